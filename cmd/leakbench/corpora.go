@@ -0,0 +1,243 @@
+package main
+
+import (
+	"bytes"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"strings"
+	"time"
+
+	"leakcheck/internal/stats"
+)
+
+// manifest lists the corpora of a throughput run. Paths are relative to
+// the manifest file.
+type manifest struct {
+	Corpora []corpusSpec `json:"corpora"`
+}
+
+// corpusSpec is one source tree to run leakcheck on
+type corpusSpec struct {
+	Name string `json:"name"`
+	Path string `json:"path"`
+	// Commit pins the snapshot: if set, the corpus must be a git checkout
+	// of exactly this commit, so results stay comparable to the baseline
+	Commit string   `json:"commit,omitempty"`
+	Args   []string `json:"args,omitempty"` // extra leakcheck options, e.g. --exclude
+}
+
+// corpusResult is the throughput of leakcheck on one corpus, taken from
+// its fastest run
+type corpusResult struct {
+	Name        string  `json:"name"`
+	Commit      string  `json:"commit,omitempty"`
+	Files       int     `json:"files"`
+	Bytes       int64   `json:"bytes"`
+	Findings    int     `json:"findings"`
+	Seconds     float64 `json:"seconds"`
+	FilesPerSec float64 `json:"files_per_sec"`
+	MBPerSec    float64 `json:"mb_per_sec"`
+	PeakRSS     uint64  `json:"peak_rss_bytes"` // highest over all runs
+}
+
+// corpusReport is the output of a throughput run, and the format of
+// --baseline files
+type corpusReport struct {
+	Corpora []corpusResult `json:"corpora"`
+}
+
+// readManifest loads a manifest and resolves its paths
+func readManifest(path string) (manifest, error) {
+	var m manifest
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return m, err
+	}
+	if err := json.Unmarshal(data, &m); err != nil {
+		return m, fmt.Errorf("%s: %w", path, err)
+	}
+	if len(m.Corpora) == 0 {
+		return m, fmt.Errorf("%s: no corpora listed", path)
+	}
+	for i := range m.Corpora {
+		c := &m.Corpora[i]
+		if c.Name == "" || c.Path == "" {
+			return m, fmt.Errorf("%s: corpus %d needs a name and a path", path, i+1)
+		}
+		if !filepath.IsAbs(c.Path) {
+			c.Path = filepath.Join(filepath.Dir(path), c.Path)
+		}
+	}
+	return m, nil
+}
+
+// checkPinned fails unless the corpus is checked out at its pinned commit
+func checkPinned(c corpusSpec) error {
+	if c.Commit == "" {
+		return nil
+	}
+	out, err := exec.Command("git", "-C", c.Path, "rev-parse", "HEAD").Output()
+	if err != nil {
+		return fmt.Errorf("corpus %s is pinned to %s but %s is not a git checkout: %w", c.Name, c.Commit, c.Path, err)
+	}
+	head := strings.TrimSpace(string(out))
+	if !strings.HasPrefix(head, c.Commit) {
+		return fmt.Errorf("corpus %s is at %s, not its pinned commit %s", c.Name, head, c.Commit)
+	}
+	return nil
+}
+
+// runCorpus runs leakcheck on c runs times and returns the fastest run,
+// with the highest peak RSS seen
+func runCorpus(leakcheck string, c corpusSpec, runs int) (corpusResult, error) {
+	res := corpusResult{Name: c.Name, Commit: c.Commit}
+	if err := checkPinned(c); err != nil {
+		return res, err
+	}
+	tmp, err := os.MkdirTemp("", "leakbench-stats-")
+	if err != nil {
+		return res, err
+	}
+	defer os.RemoveAll(tmp)
+	statsPath := filepath.Join(tmp, "stats.json")
+
+	for run := 0; run < runs; run++ {
+		os.Remove(statsPath)
+		args := append([]string{"--stats-json=" + statsPath}, c.Args...)
+		cmd := exec.Command(leakcheck, append(args, c.Path)...)
+		cmd.Stdout = io.Discard
+		var stderr bytes.Buffer
+		cmd.Stderr = &stderr
+
+		start := time.Now()
+		err := cmd.Run()
+		elapsed := time.Since(start)
+		// Exit code 1 only means findings were reported
+		var exitErr *exec.ExitError
+		if err != nil && !(errors.As(err, &exitErr) && exitErr.ExitCode() == 1) {
+			return res, fmt.Errorf("running leakcheck on %s: %w", c.Name, err)
+		}
+
+		data, err := os.ReadFile(statsPath)
+		if err != nil {
+			return res, fmt.Errorf("leakcheck on %s wrote no stats: %s", c.Name, strings.TrimSpace(stderr.String()))
+		}
+		var report stats.Report
+		if err := json.Unmarshal(data, &report); err != nil {
+			return res, fmt.Errorf("reading leakcheck stats for %s: %w", c.Name, err)
+		}
+
+		res.PeakRSS = max(res.PeakRSS, peakRSS(cmd.ProcessState))
+		if run == 0 || elapsed.Seconds() < res.Seconds {
+			res.Files = report.Files
+			res.Bytes = report.Bytes
+			res.Findings = report.Leaks
+			res.Seconds = elapsed.Seconds()
+		}
+	}
+	if res.Seconds > 0 {
+		res.FilesPerSec = float64(res.Files) / res.Seconds
+		res.MBPerSec = float64(res.Bytes) / 1e6 / res.Seconds
+	}
+	return res, nil
+}
+
+// runCorpora benchmarks leakcheck on every corpus of the manifest,
+// prints the results and, given a baseline, compares against it. It
+// returns the exit code: 1 if throughput on any corpus dropped by more
+// than threshold (a fraction), 0 otherwise.
+func runCorpora(manifestPath, leakcheck string, runs int, baselinePath string, threshold float64, asJSON bool) int {
+	if runs < 1 {
+		runs = 1
+	}
+	m, err := readManifest(manifestPath)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error reading manifest: %v\n", err)
+		return 2
+	}
+	var baseline map[string]corpusResult
+	if baselinePath != "" {
+		data, err := os.ReadFile(baselinePath)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error reading baseline: %v\n", err)
+			return 2
+		}
+		var report corpusReport
+		if err := json.Unmarshal(data, &report); err != nil {
+			fmt.Fprintf(os.Stderr, "Error reading baseline: %s: %v\n", baselinePath, err)
+			return 2
+		}
+		baseline = make(map[string]corpusResult, len(report.Corpora))
+		for _, r := range report.Corpora {
+			baseline[r.Name] = r
+		}
+	}
+
+	var report corpusReport
+	if !asJSON {
+		fmt.Printf("%-20s %8s %10s %10s %9s %10s %9s\n", "corpus", "files", "MB", "files/s", "MB/s", "peak RSS", "findings")
+	}
+	for _, c := range m.Corpora {
+		r, err := runCorpus(leakcheck, c, runs)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+			return 2
+		}
+		report.Corpora = append(report.Corpora, r)
+		if !asJSON {
+			fmt.Printf("%-20s %8d %10.1f %10.0f %9.2f %9.1fM %9d\n",
+				r.Name, r.Files, float64(r.Bytes)/1e6, r.FilesPerSec, r.MBPerSec, float64(r.PeakRSS)/(1<<20), r.Findings)
+		}
+	}
+
+	if asJSON {
+		encoder := json.NewEncoder(os.Stdout)
+		encoder.SetIndent("", "  ")
+		if err := encoder.Encode(report); err != nil {
+			fmt.Fprintf(os.Stderr, "Error writing results: %v\n", err)
+			return 2
+		}
+	}
+	if baseline == nil {
+		return 0
+	}
+	return compareBaseline(report.Corpora, baseline, threshold)
+}
+
+// compareBaseline prints how each result differs from its baseline to
+// stderr, and returns 1 if any throughput dropped by more than threshold
+func compareBaseline(results []corpusResult, baseline map[string]corpusResult, threshold float64) int {
+	code := 0
+	fmt.Fprintf(os.Stderr, "\nAgainst baseline (failing below -%.0f%% throughput):\n", threshold*100)
+	for _, r := range results {
+		base, ok := baseline[r.Name]
+		if !ok || base.MBPerSec <= 0 {
+			fmt.Fprintf(os.Stderr, "  %-20s no baseline\n", r.Name)
+			continue
+		}
+		if base.Commit != r.Commit {
+			fmt.Fprintf(os.Stderr, "  %-20s baseline was taken at commit %q, now %q; not compared\n", r.Name, base.Commit, r.Commit)
+			continue
+		}
+		change := r.MBPerSec/base.MBPerSec - 1
+		status := "ok"
+		if change < -threshold {
+			status = "REGRESSION"
+			code = 1
+		}
+		fmt.Fprintf(os.Stderr, "  %-20s %+6.1f%% MB/s (%.2f -> %.2f)", r.Name, change*100, base.MBPerSec, r.MBPerSec)
+		if base.PeakRSS > 0 && r.PeakRSS > 0 {
+			fmt.Fprintf(os.Stderr, ", %+6.1f%% peak RSS", (float64(r.PeakRSS)/float64(base.PeakRSS)-1)*100)
+		}
+		if r.Findings != base.Findings {
+			fmt.Fprintf(os.Stderr, ", findings %d -> %d", base.Findings, r.Findings)
+		}
+		fmt.Fprintf(os.Stderr, "  %s\n", status)
+	}
+	return code
+}
@@ -0,0 +1,207 @@
+package main
+
+import (
+	"encoding/json"
+	"flag"
+	"fmt"
+	"os"
+	"testing"
+
+	"leakcheck/internal/analyzer"
+	"leakcheck/internal/corpus"
+	"leakcheck/internal/parser"
+	"leakcheck/internal/scanner"
+)
+
+// result is one benchmark measurement
+type result struct {
+	Name        string  `json:"name"`
+	Iterations  int     `json:"iterations"`
+	NsPerOp     int64   `json:"ns_per_op"`
+	MBPerSec    float64 `json:"mb_per_sec,omitempty"`
+	ClassesPerS float64 `json:"classes_per_sec,omitempty"`
+	BytesPerOp  int64   `json:"bytes_per_op"`
+	AllocsPerOp int64   `json:"allocs_per_op"`
+}
+
+func main() {
+	opts := corpus.DefaultOptions()
+	flag.IntVar(&opts.Classes, "classes", opts.Classes, "Number of generated classes (each is a .h/.cpp pair)")
+	flag.IntVar(&opts.Members, "members", opts.Members, "Pointer members per class")
+	flag.IntVar(&opts.CallDepth, "depth", opts.CallDepth, "Length of the destructor's cleanup call chain")
+	flag.IntVar(&opts.Aliases, "aliases", opts.Aliases, "Alias assignments per alias-heavy method")
+	flag.Float64Var(&opts.LeakRate, "leak-rate", opts.LeakRate, "Fraction of classes generated with a leak")
+	flag.Int64Var(&opts.Seed, "seed", opts.Seed, "Seed for the generator")
+	dirFlag := flag.String("dir", "", "Write the corpus to this directory and keep it (default: temporary directory)")
+	genOnlyFlag := flag.Bool("gen-only", false, "Generate the corpus and exit without benchmarking")
+	jsonFlag := flag.Bool("json", false, "Output results in JSON format")
+	corporaFlag := flag.String("corpora", "", "Instead of benchmarking phases, run leakcheck on the corpora listed in this JSON manifest")
+	leakcheckFlag := flag.String("leakcheck", "./leakcheck", "leakcheck binary to run with --corpora")
+	runsFlag := flag.Int("runs", 3, "Runs per corpus with --corpora; the fastest counts")
+	baselineFlag := flag.String("baseline", "", "Compare --corpora results with this earlier --corpora --json output")
+	thresholdFlag := flag.Float64("threshold", 0.10, "Fail when MB/s on a corpus drops by more than this fraction of its --baseline")
+
+	flag.Usage = func() {
+		fmt.Fprintf(os.Stderr, "Usage: leakbench [options]\n\n")
+		fmt.Fprintf(os.Stderr, "Generates a synthetic C++ corpus and benchmarks each leakcheck phase on it,\n")
+		fmt.Fprintf(os.Stderr, "or with --corpora measures the whole leakcheck run on real source trees\n\n")
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		flag.PrintDefaults()
+		fmt.Fprintf(os.Stderr, "\nExamples:\n")
+		fmt.Fprintf(os.Stderr, "  leakbench                              Benchmark on a default corpus\n")
+		fmt.Fprintf(os.Stderr, "  leakbench --classes=20000 --depth=12   Benchmark a larger corpus with deep call chains\n")
+		fmt.Fprintf(os.Stderr, "  leakbench --gen-only --dir=./corpus    Only write the corpus, e.g. to run leakcheck on it\n")
+		fmt.Fprintf(os.Stderr, "  leakbench --corpora=corpora.json --baseline=baseline.json\n")
+		fmt.Fprintf(os.Stderr, "                                         Check leakcheck's throughput on real trees against a baseline\n")
+	}
+	flag.Parse()
+
+	if *corporaFlag != "" {
+		os.Exit(runCorpora(*corporaFlag, *leakcheckFlag, *runsFlag, *baselineFlag, *thresholdFlag, *jsonFlag))
+	}
+
+	dir := *dirFlag
+	if dir == "" {
+		if *genOnlyFlag {
+			fmt.Fprintln(os.Stderr, "Error: --gen-only requires --dir")
+			os.Exit(1)
+		}
+		tmp, err := os.MkdirTemp("", "leakbench-")
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error creating corpus directory: %v\n", err)
+			os.Exit(1)
+		}
+		defer os.RemoveAll(tmp)
+		dir = tmp
+	}
+
+	stats, err := corpus.Generate(dir, opts)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error generating corpus: %v\n", err)
+		os.Exit(1)
+	}
+	if !*jsonFlag {
+		fmt.Printf("Corpus: %d file(s), %.1f MB, %d class(es), %d with leaks\n",
+			stats.Files, float64(stats.Bytes)/1e6, stats.Classes, stats.Leaks)
+	}
+	if *genOnlyFlag {
+		return
+	}
+
+	results, err := runBenchmarks(dir)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		os.Exit(1)
+	}
+
+	if *jsonFlag {
+		encoder := json.NewEncoder(os.Stdout)
+		encoder.SetIndent("", "  ")
+		if err := encoder.Encode(results); err != nil {
+			fmt.Fprintf(os.Stderr, "Error writing results: %v\n", err)
+			os.Exit(1)
+		}
+		return
+	}
+	for _, r := range results {
+		fmt.Printf("%-16s %8d %14d ns/op", r.Name, r.Iterations, r.NsPerOp)
+		if r.MBPerSec > 0 {
+			fmt.Printf(" %10.2f MB/s", r.MBPerSec)
+		}
+		if r.ClassesPerS > 0 {
+			fmt.Printf(" %12.0f classes/s", r.ClassesPerS)
+		}
+		fmt.Printf(" %12d B/op %10d allocs/op\n", r.BytesPerOp, r.AllocsPerOp)
+	}
+}
+
+// runBenchmarks measures each pipeline phase over the files under dir.
+// Every phase gets the real output of the previous one as its input.
+func runBenchmarks(dir string) ([]result, error) {
+	files, err := scanner.NewScanner(nil).ScanPaths([]string{dir})
+	if err != nil {
+		return nil, err
+	}
+
+	var totalBytes int64
+	contents := make([][]byte, len(files))
+	for i, f := range files {
+		contents[i], err = os.ReadFile(f)
+		if err != nil {
+			return nil, err
+		}
+		totalBytes += int64(len(contents[i]))
+	}
+
+	parsed := make([][]parser.Class, len(files))
+	parsedClasses := 0
+	for i, f := range files {
+		parsed[i] = parser.ParseSource(f, contents[i])
+		parsedClasses += len(parsed[i])
+	}
+
+	merge := func() []parser.Class {
+		registry := parser.NewClassRegistry()
+		for _, classes := range parsed {
+			registry.AddClasses(classes)
+		}
+		return registry.MergeClasses()
+	}
+	merged := merge()
+
+	var results []result
+	add := func(name string, classes int, fn func(b *testing.B)) {
+		r := testing.Benchmark(func(b *testing.B) {
+			b.ReportAllocs()
+			fn(b)
+		})
+		res := result{
+			Name:        name,
+			Iterations:  r.N,
+			NsPerOp:     r.NsPerOp(),
+			BytesPerOp:  r.AllocedBytesPerOp(),
+			AllocsPerOp: r.AllocsPerOp(),
+		}
+		if r.Bytes > 0 && r.T > 0 {
+			res.MBPerSec = float64(r.Bytes) * float64(r.N) / 1e6 / r.T.Seconds()
+		}
+		if classes > 0 && r.T > 0 {
+			res.ClassesPerS = float64(classes) * float64(r.N) / r.T.Seconds()
+		}
+		results = append(results, res)
+	}
+
+	add("Tokenize", 0, func(b *testing.B) {
+		b.SetBytes(totalBytes)
+		for n := 0; n < b.N; n++ {
+			for _, c := range contents {
+				parser.NewLexer(c).Tokenize()
+			}
+		}
+	})
+
+	add("ParseFile", parsedClasses, func(b *testing.B) {
+		b.SetBytes(totalBytes)
+		for n := 0; n < b.N; n++ {
+			for _, f := range files {
+				if _, err := parser.ParseFile(f); err != nil {
+					b.Fatal(err)
+				}
+			}
+		}
+	})
+
+	add("MergeClasses", parsedClasses, func(b *testing.B) {
+		for n := 0; n < b.N; n++ {
+			merge()
+		}
+	})
+
+	add("AnalyzeClasses", len(merged), func(b *testing.B) {
+		for n := 0; n < b.N; n++ {
+			analyzer.AnalyzeClasses(merged)
+		}
+	})
+
+	return results, nil
+}
@@ -0,0 +1,214 @@
+package main
+
+import (
+	"bytes"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"slices"
+	"strings"
+
+	"leakcheck/internal/cache"
+	"leakcheck/internal/parser"
+	"leakcheck/internal/scanner"
+)
+
+// changedFiles returns the absolute paths of the files listed in
+// changedList (comma-separated, or @file with one path per line) and
+// of the files changed since the git ref since
+func changedFiles(changedList, since string) ([]string, error) {
+	var files []string
+
+	if strings.HasPrefix(changedList, "@") {
+		data, err := os.ReadFile(changedList[1:])
+		if err != nil {
+			return nil, err
+		}
+		files = append(files, strings.Split(string(data), "\n")...)
+	} else if changedList != "" {
+		files = append(files, strings.Split(changedList, ",")...)
+	}
+
+	if since != "" {
+		gitFiles, err := gitChangedFiles(since)
+		if err != nil {
+			return nil, err
+		}
+		files = append(files, gitFiles...)
+	}
+
+	var result []string
+	for _, f := range files {
+		f = strings.TrimSpace(f)
+		if f == "" {
+			continue
+		}
+		absPath, _ := filepath.Abs(f)
+		result = append(result, absPath)
+	}
+	return result, nil
+}
+
+// gitChangedFiles lists files that differ from ref in the working tree,
+// including untracked files, as absolute paths
+func gitChangedFiles(ref string) ([]string, error) {
+	top, err := exec.Command("git", "rev-parse", "--show-toplevel").Output()
+	if err != nil {
+		return nil, err
+	}
+	root := strings.TrimSpace(string(top))
+
+	var files []string
+	for _, args := range [][]string{
+		{"diff", "--name-only", "-z", ref, "--"},
+		{"ls-files", "--others", "--exclude-standard", "-z", "--full-name", root},
+	} {
+		out, err := exec.Command("git", args...).Output()
+		if err != nil {
+			return nil, err
+		}
+		for _, name := range bytes.Split(out, []byte{0}) {
+			if len(name) > 0 {
+				files = append(files, filepath.Join(root, string(name)))
+			}
+		}
+	}
+	return files, nil
+}
+
+// parseIncremental parses the changed files plus every indexed file that
+// defines one of the same classes, so header/implementation pairs stay
+// complete. It returns the results in scan order and the set of
+// qualified class names whose findings should be reported.
+func parseIncremental(s *scanner.Scanner, paths, changed []string, jobs int, parseCache *cache.Cache) ([]parseResult, map[string]bool, error) {
+	var roots []string
+	for _, p := range paths {
+		absPath, _ := filepath.Abs(p)
+		roots = append(roots, absPath)
+	}
+
+	var relevant []string
+	for _, f := range changed {
+		if s.Accepts(f) && underAny(f, roots) {
+			relevant = append(relevant, f)
+		}
+	}
+
+	index := parseCache.LoadIndex()
+	if index.Len() == 0 {
+		// First run: parse everything once to build the index
+		results, err := scanAndParse(s, paths, jobs, parseCache, nil)
+		if err != nil {
+			return nil, nil, err
+		}
+		index = buildIndex(parseCache, results)
+		_ = index.Save()
+
+		scope := make(map[string]bool)
+		for _, f := range relevant {
+			for _, name := range index.Classes(f) {
+				scope[name] = true
+			}
+		}
+		return results, scope, nil
+	}
+
+	// Classes touched by a change: those the file defined before and after
+	scope := make(map[string]bool)
+	var existing []string
+	for _, f := range relevant {
+		for _, name := range index.Classes(f) {
+			scope[name] = true
+		}
+		if _, err := os.Stat(f); err == nil {
+			existing = append(existing, f)
+		} else {
+			index.Remove(f)
+		}
+	}
+
+	parsed := make(map[string]parseResult)
+	for _, result := range parseList(existing, jobs, parseCache, nil) {
+		parsed[result.file] = result
+		if result.err == nil {
+			index.Set(result.file, result.classes)
+			for _, class := range result.classes {
+				scope[class.QualifiedName()] = true
+			}
+		}
+	}
+
+	// Pull in the other halves of every touched class
+	var partners []string
+	for _, f := range index.FilesDefining(scope) {
+		if _, done := parsed[f]; !done {
+			partners = append(partners, f)
+		}
+	}
+	// Only the touched classes of partner files are needed; the rest of a
+	// cached partner is not even decoded. The class file index has no
+	// namespaces, so every class of a touched name is kept.
+	bases := make(map[string]bool, len(scope))
+	for name := range scope {
+		bases[parser.BaseName(name)] = true
+	}
+	touched := func(name string) bool { return bases[name] }
+	for _, result := range parseList(partners, jobs, parseCache, touched) {
+		if os.IsNotExist(result.err) {
+			index.Remove(result.file)
+			continue
+		}
+		parsed[result.file] = result
+	}
+	_ = index.Save()
+
+	results := make([]parseResult, 0, len(parsed))
+	for _, result := range parsed {
+		results = append(results, result)
+	}
+	// Merging prefers earlier definitions, so keep the order a full scan
+	// would parse in
+	order := scanner.ScanOrder(roots)
+	slices.SortFunc(results, func(a, b parseResult) int { return order(a.file, b.file) })
+	return results, scope, nil
+}
+
+// buildIndex creates a class index from a full set of parse results
+func buildIndex(parseCache *cache.Cache, results []parseResult) *cache.Index {
+	index := parseCache.NewIndex()
+	for _, result := range results {
+		if result.err == nil {
+			index.Set(result.file, result.classes)
+		}
+	}
+	return index
+}
+
+// inScope reports whether scope (qualified class names) covers the class
+// with the given qualified name. An unqualified name in scope covers
+// same-named classes in any namespace, as the registry may have merged it
+// into one of them.
+func inScope(scope map[string]bool, class string) bool {
+	return scope[class] || scope[parser.BaseName(class)]
+}
+
+// filterLeaks keeps the leaks found in classes that are in scope
+func filterLeaks(leaks []parser.Leak, scope map[string]bool) []parser.Leak {
+	var kept []parser.Leak
+	for _, leak := range leaks {
+		if inScope(scope, leak.ClassName) {
+			kept = append(kept, leak)
+		}
+	}
+	return kept
+}
+
+// underAny reports whether file is inside one of roots
+func underAny(file string, roots []string) bool {
+	for _, root := range roots {
+		if file == root || strings.HasPrefix(file, root+string(filepath.Separator)) {
+			return true
+		}
+	}
+	return false
+}
@@ -1,49 +1,133 @@
 package main
 
 import (
+	"errors"
 	"flag"
 	"fmt"
 	"os"
+	"runtime"
+	"slices"
 	"strings"
+	"sync"
+	"time"
 
 	"leakcheck/internal/analyzer"
+	"leakcheck/internal/cache"
 	"leakcheck/internal/parser"
 	"leakcheck/internal/reporter"
 	"leakcheck/internal/scanner"
+	"leakcheck/internal/shard"
+	"leakcheck/internal/stats"
 )
 
 var (
 	version = "2.0.0"
+
+	// limits bounds the work spent parsing each file, from the
+	// --max-file-bytes, --max-file-tokens and --parse-timeout flags
+	limits parser.Limits
 )
 
 func main() {
+	// Subcommands
+	if len(os.Args) > 1 {
+		switch os.Args[1] {
+		case "serve":
+			runServe(os.Args[2:])
+			return
+		case "notify":
+			runNotify(os.Args[2:])
+			return
+		case "merge":
+			runMerge(os.Args[2:])
+			return
+		}
+	}
+
 	// Define flags
 	excludeFlag := flag.String("exclude", "", "Comma-separated list of directories to exclude (e.g., vendor,build,third_party)")
-	jsonFlag := flag.Bool("json", false, "Output results in JSON format")
+	noIgnoreFlag := flag.Bool("no-ignore", false, "Scan files matched by .gitignore and .leakcheckignore files too")
+	gitFilesFlag := flag.Bool("git-files", false, "List files with git ls-files instead of walking directories (tracked and untracked, not ignored)")
+	jsonFlag := flag.Bool("json", false, "Output results in JSON format (same as --format=json)")
+	formatFlag := flag.String("format", "console", "Output format: console, json, ndjson (one JSON record per line, streamed) or sarif")
+	maxFindingsFlag := flag.Int("max-findings", 0, "Show at most this many findings per file in console output; 0 shows all (the summary counts all)")
+	jobsFlag := flag.Int("jobs", runtime.GOMAXPROCS(0), "Number of parallel workers for parsing and analysis")
+	cacheFlag := flag.String("cache-dir", "", "Directory for the parse cache (e.g., .leakcheck-cache); disabled if empty")
+	changedFlag := flag.String("changed-files", "", "Comma-separated list (or @file) of changed files; only classes they touch are analyzed (requires --cache-dir)")
+	sinceFlag := flag.String("since", "", "Only analyze classes touched by changes since this git ref (requires --cache-dir)")
+	shardFlag := flag.String("shard", "", "Parse only shard i/N of the files and write the classes to --shard-out, for 'leakcheck merge'")
+	shardOutFlag := flag.String("shard-out", "", "File to write the --shard dump to")
+	maxBytesFlag := flag.Int("max-file-bytes", 0, "Skip files larger than this many bytes, with a warning; 0 is unlimited")
+	maxTokensFlag := flag.Int("max-file-tokens", 0, "Stop parsing and skip a file after this many tokens, with a warning; 0 is unlimited")
+	parseTimeoutFlag := flag.Duration("parse-timeout", 0, "Stop parsing and skip a file after this long (e.g., 10s), with a warning; 0 is unlimited")
+	rulesFlag := flag.String("rules", "", "Comma-separated list of rules to run (default: all; see the README for rule IDs)")
+	disableRuleFlag := flag.String("disable-rule", "", "Comma-separated list of rules not to run")
+	prefilterFlag := flag.Bool("prefilter", false, "Skip lexing files without new or delete unless they share a class with a file that has one")
+	statsFlag := flag.Bool("stats", false, "Print per-phase timing, throughput and allocation stats to stderr")
+	statsJSONFlag := flag.String("stats-json", "", "Write the --stats report as JSON to this file")
+	statsTopFlag := flag.Int("stats-top", 10, "Number of slowest files to list in the stats")
+	cpuProfileFlag := flag.String("cpuprofile", "", "Write a CPU profile to this file")
+	memProfileFlag := flag.String("memprofile", "", "Write a heap profile to this file at exit")
+	traceFlag := flag.String("trace", "", "Write an execution trace to this file")
 	versionFlag := flag.Bool("version", false, "Print version and exit")
 	helpFlag := flag.Bool("help", false, "Show help message")
 
 	flag.Usage = func() {
-		fmt.Fprintf(os.Stderr, "Usage: leakcheck [options] <path> [paths...]\n\n")
+		fmt.Fprintf(os.Stderr, "Usage: leakcheck [options] <path> [paths...]\n")
+		fmt.Fprintf(os.Stderr, "       leakcheck serve [options] <path> [paths...]\n")
+		fmt.Fprintf(os.Stderr, "       leakcheck notify [options] [changed files...]\n")
+		fmt.Fprintf(os.Stderr, "       leakcheck merge [options] <shard dumps...>\n\n")
 		fmt.Fprintf(os.Stderr, "C++ Memory Leak Detector - Static analysis tool to detect potential memory leaks\n\n")
 		fmt.Fprintf(os.Stderr, "Options:\n")
 		flag.PrintDefaults()
 		fmt.Fprintf(os.Stderr, "\nExamples:\n")
 		fmt.Fprintf(os.Stderr, "  leakcheck ./src                    Scan all C++ files in ./src\n")
 		fmt.Fprintf(os.Stderr, "  leakcheck --exclude=vendor ./      Scan all files, excluding vendor directory\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --git-files ./           Scan the files git knows about, without walking the tree\n")
 		fmt.Fprintf(os.Stderr, "  leakcheck --json ./src > out.json  Output results as JSON\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --format=ndjson ./src | jq -c 'select(.type == \"leak\")'\n")
+		fmt.Fprintf(os.Stderr, "                                     Stream one JSON record per finding\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --format=sarif ./src > leakcheck.sarif\n")
+		fmt.Fprintf(os.Stderr, "                                     Write a SARIF log for code-scanning tools\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --jobs=4 ./src           Parse and analyze using 4 workers\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --cache-dir=.leakcheck-cache ./src\n")
+		fmt.Fprintf(os.Stderr, "                                     Reuse parse results for unchanged files\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --cache-dir=.leakcheck-cache --since=origin/main ./src\n")
+		fmt.Fprintf(os.Stderr, "                                     Only report classes touched since origin/main\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --shard=1/2 --shard-out=1.shard ./src; leakcheck merge 1.shard 2.shard\n")
+		fmt.Fprintf(os.Stderr, "                                     Spread parsing over several machines\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --max-file-bytes=4000000 --parse-timeout=10s ./src\n")
+		fmt.Fprintf(os.Stderr, "                                     Skip huge or pathological files instead of stalling\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --disable-rule=reassignment ./src\n")
+		fmt.Fprintf(os.Stderr, "                                     Run every rule except reassignment\n")
+		fmt.Fprintf(os.Stderr, "  leakcheck --stats --cpuprofile=cpu.out ./src\n")
+		fmt.Fprintf(os.Stderr, "                                     Show where the time went and save a CPU profile\n")
 	}
 
 	flag.Parse()
 
+	// Start profiling and stats; from here on, exit() stops the profiles and
+	// writes the stats before exiting
+	if err := startProfiles(*cpuProfileFlag, *memProfileFlag, *traceFlag); err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		os.Exit(1)
+	}
+	var st *stats.Collector
+	if *statsFlag || *statsJSONFlag != "" {
+		st = stats.New(*statsTopFlag)
+		atExit = append(atExit, func() {
+			writeStats(st.Finish(), *statsFlag, *statsJSONFlag)
+		})
+	}
+
 	if *helpFlag {
 		flag.Usage()
-		os.Exit(0)
+		exit(0)
 	}
 
 	if *versionFlag {
 		fmt.Printf("leakcheck version %s\n", version)
-		os.Exit(0)
+		exit(0)
 	}
 
 	// Get paths to scan
@@ -51,66 +135,459 @@ func main() {
 	if len(paths) == 0 {
 		fmt.Fprintln(os.Stderr, "Error: No paths specified")
 		fmt.Fprintln(os.Stderr, "Run 'leakcheck --help' for usage")
-		os.Exit(1)
+		exit(1)
+	}
+
+	format, err := resolveFormat(*formatFlag, *jsonFlag)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		exit(1)
+	}
+	console := format == reporter.FormatConsole
+	ruleIDs, err := selectRules(*rulesFlag, *disableRuleFlag)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		exit(1)
 	}
 
 	// Parse exclude patterns
-	var excludes []string
-	if *excludeFlag != "" {
-		excludes = strings.Split(*excludeFlag, ",")
-		for i := range excludes {
-			excludes[i] = strings.TrimSpace(excludes[i])
+	excludes := splitList(*excludeFlag)
+	limits = parser.Limits{MaxBytes: *maxBytesFlag, MaxTokens: *maxTokensFlag, Timeout: *parseTimeoutFlag}
+
+	// Open the parse cache
+	var parseCache *cache.Cache
+	if *cacheFlag != "" {
+		var err error
+		parseCache, err = cache.New(*cacheFlag, version)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error opening cache: %v\n", err)
+			exit(1)
 		}
 	}
 
-	// Scan for C++ files
 	s := scanner.NewScanner(excludes)
-	files, err := s.ScanPaths(paths)
-	if err != nil {
-		fmt.Fprintf(os.Stderr, "Error scanning paths: %v\n", err)
-		os.Exit(1)
+	s.IgnoreFiles = !*noIgnoreFlag
+	s.GitFiles = *gitFilesFlag
+	// Classes are registered in scan order, so the result does not depend on
+	// which worker finished first
+	registry := parser.NewClassRegistry()
+	var results []parseResult
+	var scope map[string]bool // classes to report on; nil reports all
+
+	incremental := *changedFlag != "" || *sinceFlag != ""
+	st.StartPhase(stats.PhaseParse)
+
+	if *shardFlag != "" {
+		spec, err := shard.ParseSpec(*shardFlag)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+			exit(1)
+		}
+		if *shardOutFlag == "" {
+			fmt.Fprintln(os.Stderr, "Error: --shard requires --shard-out")
+			exit(1)
+		}
+		if incremental || *prefilterFlag {
+			fmt.Fprintln(os.Stderr, "Error: --shard cannot be combined with --changed-files, --since or --prefilter")
+			exit(1)
+		}
+
+		// Parse this shard's files; analysis happens in 'leakcheck merge'
+		parsed, total, err := writeShard(s, paths, spec, *shardOutFlag, *jobsFlag, parseCache, st)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+			exit(1)
+		}
+		if console {
+			fmt.Printf("Shard %s: parsed %d of %d file(s), wrote %s\n", spec, parsed, total, *shardOutFlag)
+		}
+		exit(0)
 	}
 
-	if len(files) == 0 {
-		fmt.Fprintln(os.Stderr, "No C++ files found")
-		os.Exit(0)
+	if incremental {
+		if parseCache == nil {
+			fmt.Fprintln(os.Stderr, "Error: --changed-files and --since require --cache-dir")
+			exit(1)
+		}
+		if *prefilterFlag {
+			fmt.Fprintln(os.Stderr, "Error: --prefilter cannot be combined with --changed-files or --since")
+			exit(1)
+		}
+		changed, err := changedFiles(*changedFlag, *sinceFlag)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error listing changed files: %v\n", err)
+			exit(1)
+		}
+
+		// Parse only the changed files and the files they share classes with
+		results, scope, err = parseIncremental(s, paths, changed, *jobsFlag, parseCache)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error scanning paths: %v\n", err)
+			exit(1)
+		}
+	} else if *prefilterFlag {
+		// Skipped files leave no trace in the class index, so it is not rebuilt
+		var err error
+		results, err = scanAndPrefilter(s, paths, *jobsFlag, parseCache)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error scanning paths: %v\n", err)
+			exit(1)
+		}
+	} else {
+		// Scan for C++ files and parse them while the walk is still running;
+		// classes are merged as soon as every earlier file has been parsed
+		var err error
+		results, err = scanAndParse(s, paths, *jobsFlag, parseCache, func(result parseResult) {
+			register(registry, st, result)
+		})
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error scanning paths: %v\n", err)
+			exit(1)
+		}
+		if parseCache != nil {
+			// Rebuild the class index for later --changed-files/--since runs
+			_ = buildIndex(parseCache, results).Save()
+		}
 	}
 
-	if !*jsonFlag {
-		fmt.Printf("Scanning %d file(s)...\n", len(files))
+	if len(results) == 0 {
+		if scope != nil {
+			fmt.Fprintln(os.Stderr, "No changed C++ files found")
+		} else {
+			fmt.Fprintln(os.Stderr, "No C++ files found")
+		}
+		exit(0)
 	}
 
-	// Parse all files and register classes
-	registry := parser.NewClassRegistry()
-	for _, file := range files {
-		classes, err := parser.ParseFile(file)
-		if err != nil {
-			fmt.Fprintf(os.Stderr, "Warning: Error parsing %s: %v\n", file, err)
-			continue
+	if console {
+		fmt.Printf("Scanning %d file(s)...\n", len(results))
+	}
+
+	st.StartPhase(stats.PhaseMerge)
+	if incremental || *prefilterFlag {
+		for _, result := range results {
+			register(registry, st, result)
 		}
-		registry.AddClasses(classes)
 	}
 
 	// Merge classes from headers and implementations
 	allClasses := registry.MergeClasses()
 
-	if !*jsonFlag {
+	if console {
 		fmt.Printf("Found %d class(es) with pointer members\n", countClassesWithPointers(allClasses))
 	}
 
+	found := analyzeAndReport(allClasses, format, *jobsFlag, *maxFindingsFlag, ruleIDs, scope, st)
+
+	st.SetResults(len(allClasses), found)
+
+	// Exit with error code if leaks found
+	if found > 0 {
+		exit(1)
+	}
+	exit(0)
+}
+
+// resolveFormat parses --format; --json is kept as an alias for --format=json
+func resolveFormat(name string, json bool) (reporter.Format, error) {
+	format, err := reporter.ParseFormat(name)
+	if err != nil {
+		return "", err
+	}
+	if json {
+		if format != reporter.FormatConsole && format != reporter.FormatJSON {
+			return "", fmt.Errorf("--json conflicts with --format=%s", name)
+		}
+		format = reporter.FormatJSON
+	}
+	return format, nil
+}
+
+// selectRules resolves --rules and --disable-rule to the IDs of the rules
+// to run, rejecting unknown IDs
+func selectRules(enable, disable string) ([]string, error) {
+	known := analyzer.RuleIDs()
+	ids := known
+	if enable != "" {
+		ids = splitList(enable)
+	}
+	disabled := splitList(disable)
+	for _, id := range append(slices.Clip(ids), disabled...) {
+		if !slices.Contains(known, id) {
+			return nil, fmt.Errorf("unknown rule %q (known rules: %s)", id, strings.Join(known, ", "))
+		}
+	}
+	var selected []string
+	for _, id := range ids {
+		if !slices.Contains(disabled, id) {
+			selected = append(selected, id)
+		}
+	}
+	if len(selected) == 0 {
+		return nil, errors.New("--rules and --disable-rule leave no rule to run")
+	}
+	return selected, nil
+}
+
+// newAnalyzer returns an analyzer running the given rules on jobs workers
+func newAnalyzer(jobs int, ruleIDs []string) *analyzer.Analyzer {
+	a := analyzer.NewAnalyzer()
+	a.SetWorkers(jobs)
+	if err := a.SetRules(ruleIDs); err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		exit(1)
+	}
+	return a
+}
+
+// analyzeAndReport analyzes classes with the given rules and writes the
+// findings in format to stdout, returning how many were reported. A non-nil
+// scope limits the findings to the classes it names; maxPerFile caps the
+// console report. Rule timings are added to st.
+func analyzeAndReport(classes []parser.Class, format reporter.Format, jobs, maxPerFile int, ruleIDs []string, scope map[string]bool, st *stats.Collector) int {
 	// Analyze for leaks
-	leaks := analyzer.AnalyzeClasses(allClasses)
+	a := newAnalyzer(jobs, ruleIDs)
+	a.SetTiming(st != nil)
+	a.AddClasses(classes)
+	defer func() {
+		for _, rule := range a.RuleStats() {
+			st.AddRule(rule.ID, rule.Duration, rule.Findings)
+		}
+	}()
+	r := reporter.NewReporter(os.Stdout, format)
+	r.SetToolVersion(version)
+	r.SetWorkers(jobs)
+	r.SetMaxFindingsPerFile(maxPerFile)
+
+	if format.Streams() {
+		// Write findings as each shard of classes is analyzed
+		st.StartPhase(stats.PhaseAnalyzeReport)
+		stream := r.Stream()
+		a.AnalyzeEach(func(leaks []parser.Leak) {
+			if scope != nil {
+				leaks = filterLeaks(leaks, scope)
+			}
+			stream.Write(leaks)
+		})
+		if err := stream.Close(); err != nil {
+			fmt.Fprintf(os.Stderr, "Error writing report: %v\n", err)
+			exit(1)
+		}
+		return stream.Summary().TotalIssues
+	}
+
+	st.StartPhase(stats.PhaseAnalyze)
+	leaks := a.Analyze()
+	if scope != nil {
+		leaks = filterLeaks(leaks, scope)
+	}
 
 	// Report results
-	r := reporter.NewReporter(os.Stdout, *jsonFlag)
+	st.StartPhase(stats.PhaseReport)
 	if err := r.Report(leaks); err != nil {
 		fmt.Fprintf(os.Stderr, "Error writing report: %v\n", err)
-		os.Exit(1)
+		exit(1)
 	}
+	return len(leaks)
+}
 
-	// Exit with error code if leaks found
-	if len(leaks) > 0 {
-		os.Exit(1)
+// parseResult holds the outcome of parsing a single file
+type parseResult struct {
+	index   int
+	file    string
+	classes []parser.Class
+	err     error
+
+	bytes   int64         // size of the source
+	tokens  int           // tokens lexed; 0 when loaded from the cache
+	cached  bool          // loaded from the parse cache
+	elapsed time.Duration // time spent reading and parsing
+
+	// skipped is set when the prefilter found no new or delete and the file
+	// was not lexed; names then holds the classes it may define
+	skipped bool
+	names   []string
+}
+
+// scanAndParse streams files from the scanner into a bounded pool of
+// parse workers. Results are returned in scan order, and passed to consume
+// in scan order as soon as they and all earlier results are ready.
+func scanAndParse(s *scanner.Scanner, paths []string, jobs int, parseCache *cache.Cache, consume func(parseResult)) ([]parseResult, error) {
+	return parseAll(func(emit func(file string) error) error {
+		return s.ScanStream(paths, emit)
+	}, jobs, func(file string) parseResult {
+		return parseFile(file, parseCache, nil)
+	}, consume)
+}
+
+// parseList parses a fixed list of files. Results are returned in list
+// order. A non-nil keep limits each result to the classes it accepts.
+func parseList(files []string, jobs int, parseCache *cache.Cache, keep func(name string) bool) []parseResult {
+	results, _ := parseAll(func(emit func(file string) error) error {
+		for _, file := range files {
+			if err := emit(file); err != nil {
+				return err
+			}
+		}
+		return nil
+	}, jobs, func(file string) parseResult {
+		return parseFile(file, parseCache, keep)
+	}, nil)
+	return results
+}
+
+// parseAll parses the files passed to emit by produce with parse, using a
+// bounded pool of workers. Results are returned in the order files were emitted.
+func parseAll(produce func(emit func(file string) error) error, jobs int, parse func(file string) parseResult, consume func(parseResult)) ([]parseResult, error) {
+	if jobs < 1 {
+		jobs = 1
+	}
+
+	type parseJob struct {
+		index int
+		file  string
+	}
+	jobQueue := make(chan parseJob, jobs)
+	resultQueue := make(chan parseResult, jobs)
+
+	var scanErr error
+	go func() {
+		defer close(jobQueue)
+		next := 0
+		scanErr = produce(func(file string) error {
+			jobQueue <- parseJob{index: next, file: file}
+			next++
+			return nil
+		})
+	}()
+
+	var wg sync.WaitGroup
+	for w := 0; w < jobs; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for job := range jobQueue {
+				start := time.Now()
+				result := parse(job.file)
+				result.index = job.index
+				result.elapsed = time.Since(start)
+				resultQueue <- result
+			}
+		}()
+	}
+	go func() {
+		wg.Wait()
+		close(resultQueue)
+	}()
+
+	var results []parseResult
+	ready := 0 // first result not yet passed to consume
+	for result := range resultQueue {
+		for len(results) <= result.index {
+			results = append(results, parseResult{})
+		}
+		results[result.index] = result
+		if consume == nil {
+			continue
+		}
+		for ready < len(results) && results[ready].file != "" {
+			consume(results[ready])
+			ready++
+		}
+	}
+
+	// jobQueue is closed only after produce returns, so scanErr is
+	// safe to read once every worker has finished
+	if scanErr != nil {
+		return nil, scanErr
+	}
+	return results, nil
+}
+
+// register adds a parse result's classes to the registry, or reports its error
+func register(registry *parser.ClassRegistry, st *stats.Collector, result parseResult) {
+	if reason, ok := limitReason(result.err); ok {
+		fmt.Fprintf(os.Stderr, "Warning: Skipping %s: %s\n", result.file, reason)
+		st.LimitFile(result.file, reason)
+		return
+	}
+	if result.err != nil {
+		fmt.Fprintf(os.Stderr, "Warning: Error parsing %s: %v\n", result.file, result.err)
+		return
+	}
+	if result.skipped {
+		st.SkipFile(result.bytes)
+		return
+	}
+	registry.AddClasses(result.classes)
+	st.AddFile(result.fileStats())
+}
+
+// limitReason returns the message of err if it reports a file that went
+// over a parse limit
+func limitReason(err error) (string, bool) {
+	var limitErr *parser.LimitError
+	if errors.As(err, &limitErr) {
+		return limitErr.Error(), true
+	}
+	return "", false
+}
+
+// fileStats returns the parse cost of the result, for --stats
+func (result parseResult) fileStats() stats.File {
+	return stats.File{
+		Path:     result.file,
+		Bytes:    result.bytes,
+		Tokens:   result.tokens,
+		Duration: result.elapsed,
+		Cached:   result.cached,
+	}
+}
+
+// parseFile parses a single file, going through the cache when enabled
+func parseFile(file string, parseCache *cache.Cache, keep func(name string) bool) parseResult {
+	result := parseResult{file: file}
+	content, release, err := parser.ReadSource(file)
+	if err != nil {
+		result.err = err
+		return result
+	}
+	defer release()
+	result.bytes = int64(len(content))
+	parseContent(&result, content, parseCache, keep)
+	return result
+}
+
+// parseContent parses a file's content into result, going through the
+// cache when enabled. A non-nil keep limits the result to the classes
+// whose unqualified name it accepts; cached entries then only decode those.
+func parseContent(result *parseResult, content []byte, parseCache *cache.Cache, keep func(name string) bool) {
+	var key string
+	// Over the size limit whether or not it was cached
+	if result.err = limits.CheckSize(len(content)); result.err != nil {
+		return
+	}
+	if parseCache != nil {
+		key = parseCache.Key(content)
+		if classes, ok := parseCache.Load(key, result.file, keep); ok {
+			result.classes = classes
+			result.cached = true
+			return
+		}
+	}
+
+	result.classes, result.tokens, result.err = parser.ParseSourceLimited(result.file, content, limits)
+	if result.err != nil {
+		return
+	}
+	if parseCache != nil {
+		// The cache is best-effort: a failed write only costs a re-parse next run
+		_ = parseCache.Store(key, result.classes)
+	}
+	if keep != nil {
+		result.classes = slices.DeleteFunc(result.classes, func(class parser.Class) bool {
+			return !keep(class.Name)
+		})
 	}
 }
 
@@ -0,0 +1,233 @@
+package main
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"slices"
+	"testing"
+
+	"leakcheck/internal/analyzer"
+	"leakcheck/internal/cache"
+	"leakcheck/internal/corpus"
+	"leakcheck/internal/parser"
+	"leakcheck/internal/scanner"
+	"leakcheck/internal/shard"
+)
+
+// describeLeaks formats findings for comparison, sorted so runs that
+// merge in the same order but report in a different one compare equal
+func describeLeaks(leaks []parser.Leak) []string {
+	out := make([]string, len(leaks))
+	for i, leak := range leaks {
+		out[i] = fmt.Sprintf("%s:%d %s::%s %s", leak.SourceFile, leak.Line, leak.ClassName, leak.VarName, leak.Rule)
+	}
+	slices.Sort(out)
+	return out
+}
+
+// analyzeResults merges and analyzes parse results the way main does,
+// keeping the findings of classes in scope (nil for all)
+func analyzeResults(results []parseResult, scope map[string]bool) []string {
+	registry := parser.NewClassRegistry()
+	for _, result := range results {
+		register(registry, nil, result)
+	}
+	return analyzeClasses(registry.MergeClasses(), scope)
+}
+
+func analyzeClasses(classes []parser.Class, scope map[string]bool) []string {
+	a := newAnalyzer(2, analyzer.RuleIDs())
+	a.AddClasses(classes)
+	leaks := a.Analyze()
+	if scope != nil {
+		leaks = filterLeaks(leaks, scope)
+	}
+	return describeLeaks(leaks)
+}
+
+// fullRun returns the findings of a normal run over paths
+func fullRun(t *testing.T, paths []string) []string {
+	t.Helper()
+	return analyzeClasses(parseTree(t, paths), nil)
+}
+
+// testTree returns a copy of testdata plus a small generated corpus, so
+// tests may modify it
+func testTree(t *testing.T) string {
+	t.Helper()
+	dir := t.TempDir()
+	entries, err := os.ReadDir(filepath.Join("..", "..", "testdata"))
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, entry := range entries {
+		data, err := os.ReadFile(filepath.Join("..", "..", "testdata", entry.Name()))
+		if err != nil {
+			t.Fatal(err)
+		}
+		writeFile(t, filepath.Join(dir, "testdata", entry.Name()), string(data))
+	}
+	opts := corpus.DefaultOptions()
+	opts.Classes = 40
+	opts.ClassesPerDir = 10
+	if _, err := corpus.Generate(filepath.Join(dir, "corpus"), opts); err != nil {
+		t.Fatal(err)
+	}
+	return dir
+}
+
+func writeFile(t *testing.T, path, content string) {
+	t.Helper()
+	if err := os.MkdirAll(filepath.Dir(path), 0o755); err != nil {
+		t.Fatal(err)
+	}
+	if err := os.WriteFile(path, []byte(content), 0o644); err != nil {
+		t.Fatal(err)
+	}
+}
+
+func TestPrefilterMatchesFullParse(t *testing.T) {
+	dir := testTree(t)
+	// A header without new or delete that completes a class
+	writeFile(t, filepath.Join(dir, "split", "holder.h"), "class Holder {\n  int *p;\npublic:\n  Holder();\n};\n")
+	writeFile(t, filepath.Join(dir, "split", "holder.cpp"), "#include \"holder.h\"\nHolder::Holder() { p = new int; }\n")
+
+	want := fullRun(t, []string{dir})
+	results, err := scanAndPrefilter(scanner.NewScanner(nil), []string{dir}, 4, nil)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if got := analyzeResults(results, nil); !slices.Equal(got, want) {
+		t.Errorf("prefiltered run found\n%q\nwant\n%q", got, want)
+	}
+}
+
+func TestIncrementalMatchesFullParse(t *testing.T) {
+	dir := testTree(t)
+	// Two roots whose scan order is not the path order; the earlier
+	// definition wins the merge
+	writeFile(t, filepath.Join(dir, "z", "dup.cpp"), "class Dup {\n  int *z;\npublic:\n  Dup() { z = new int; }\n  ~Dup() {}\n};\n")
+	writeFile(t, filepath.Join(dir, "a", "dup.cpp"), "class Dup {\n  int *a;\npublic:\n  Dup() { a = new int; }\n  ~Dup() {}\n};\n")
+	paths := []string{filepath.Join(dir, "z"), filepath.Join(dir, "a"), filepath.Join(dir, "testdata"), filepath.Join(dir, "corpus")}
+	parseCache, err := cache.New(filepath.Join(dir, ".cache"), "test")
+	if err != nil {
+		t.Fatal(err)
+	}
+	s := scanner.NewScanner(nil)
+
+	// The first run builds the index
+	if _, _, err := parseIncremental(s, paths, nil, 4, parseCache); err != nil {
+		t.Fatal(err)
+	}
+
+	for _, change := range []struct {
+		file, content string
+	}{
+		{filepath.Join(dir, "a", "dup.cpp"), "class Dup {\n  int *a;\npublic:\n  Dup() { a = new int[2]; }\n  ~Dup() { delete a; }\n};\n"},
+		{filepath.Join(dir, "testdata", "cross_file_test.h"), "class CrossFileClass {\n  int *data;\n  char *name;\npublic:\n  CrossFileClass();\n  ~CrossFileClass();\n};\n"},
+		{filepath.Join(dir, "testdata", "new_file.cpp"), "class Fresh {\n  int *p;\npublic:\n  Fresh() { p = new int; }\n};\n"},
+	} {
+		writeFile(t, change.file, change.content)
+		results, scope, err := parseIncremental(s, paths, []string{change.file}, 4, parseCache)
+		if err != nil {
+			t.Fatal(err)
+		}
+		want := analyzeClasses(parseTree(t, paths), scope)
+		if got := analyzeResults(results, scope); !slices.Equal(got, want) {
+			t.Errorf("after changing %s, incremental run found\n%q\nwant\n%q", filepath.Base(change.file), got, want)
+		}
+	}
+}
+
+func TestShardsMatchFullParse(t *testing.T) {
+	dir := testTree(t)
+	paths := []string{filepath.Join(dir, "testdata"), filepath.Join(dir, "corpus")}
+	want := fullRun(t, paths)
+
+	var dumps []*shard.Dump
+	for i := 1; i <= 3; i++ {
+		out := filepath.Join(dir, fmt.Sprintf("shard%d.lks", i))
+		if _, _, err := writeShard(scanner.NewScanner(nil), paths, shard.Spec{Index: i, Count: 3}, out, 2, nil, nil); err != nil {
+			t.Fatal(err)
+		}
+		dump, err := shard.Read(out)
+		if err != nil {
+			t.Fatal(err)
+		}
+		dumps = append(dumps, dump)
+	}
+	entries, err := shard.Merge(dumps)
+	if err != nil {
+		t.Fatal(err)
+	}
+	registry := parser.NewClassRegistry()
+	for _, entry := range entries {
+		registry.AddClasses(entry.Classes)
+	}
+	if got := analyzeClasses(registry.MergeClasses(), nil); !slices.Equal(got, want) {
+		t.Errorf("merged shards found\n%q\nwant\n%q", got, want)
+	}
+}
+
+func TestShardRecordsLimitSkips(t *testing.T) {
+	dir := t.TempDir()
+	writeFile(t, filepath.Join(dir, "small.cpp"), "class Small {};\n")
+	writeFile(t, filepath.Join(dir, "large.cpp"), "class Large {\n  int *p;\npublic:\n  Large() { p = new int; }\n};\n")
+	limits = parser.Limits{MaxBytes: 32}
+	defer func() { limits = parser.Limits{} }()
+
+	out := filepath.Join(dir, "shard.lks")
+	if _, _, err := writeShard(scanner.NewScanner(nil), []string{dir}, shard.Spec{Index: 1, Count: 1}, out, 2, nil, nil); err != nil {
+		t.Fatal(err)
+	}
+	dump, err := shard.Read(out)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, entry := range dump.Entries {
+		skipped := filepath.Base(entry.File) == "large.cpp"
+		if entry.Error != "" || (entry.Skipped != "") != skipped {
+			t.Errorf("entry %s: error %q, skipped %q", filepath.Base(entry.File), entry.Error, entry.Skipped)
+		}
+	}
+}
+
+func TestWorkspaceMatchesFullParse(t *testing.T) {
+	dir := testTree(t)
+	paths := []string{dir}
+	w := newWorkspace(scanner.NewScanner(nil), paths, 2, nil)
+	if _, err := w.poll(); err != nil {
+		t.Fatal(err)
+	}
+	if got, want := describeLeaks(w.findings(nil)), fullRun(t, paths); !slices.Equal(got, want) {
+		t.Errorf("workspace found\n%q\nwant\n%q", got, want)
+	}
+
+	// Fix one leak and add another; the next poll picks both up
+	writeFile(t, filepath.Join(dir, "testdata", "cross_file_test.cpp"), "#include \"cross_file_test.h\"\n")
+	writeFile(t, filepath.Join(dir, "extra.cpp"), "class Extra {\n  int *p;\npublic:\n  Extra() { p = new int; }\n};\n")
+	if _, err := w.poll(); err != nil {
+		t.Fatal(err)
+	}
+	if got, want := describeLeaks(w.findings(nil)), fullRun(t, paths); !slices.Equal(got, want) {
+		t.Errorf("workspace after changes found\n%q\nwant\n%q", got, want)
+	}
+	if resp, want := w.handle(serveRequest{Method: "status"}), len(parseTree(t, paths)); resp.Classes != want {
+		t.Errorf("status reports %d classes, want %d", resp.Classes, want)
+	}
+}
+
+// parseTree returns the merged classes of a full run
+func parseTree(t *testing.T, paths []string) []parser.Class {
+	t.Helper()
+	results, err := scanAndParse(scanner.NewScanner(nil), paths, 4, nil, nil)
+	if err != nil {
+		t.Fatal(err)
+	}
+	registry := parser.NewClassRegistry()
+	for _, result := range results {
+		register(registry, nil, result)
+	}
+	return registry.MergeClasses()
+}
@@ -0,0 +1,94 @@
+package main
+
+import (
+	"leakcheck/internal/cache"
+	"leakcheck/internal/parser"
+	"leakcheck/internal/scanner"
+)
+
+// scanAndPrefilter scans paths and parses only the files that can affect a
+// finding. A first pass parses every file containing new or delete and
+// pre-scans the rest for the class names they may define; a second pass
+// parses the skipped files that share a name with a parsed class using new
+// or delete, since merging needs their member declarations and destructors.
+// Every rule needs a new or delete in the merged class, so dropping the
+// other classes changes no finding.
+// Results are returned in scan order, skipped files included.
+func scanAndPrefilter(s *scanner.Scanner, paths []string, jobs int, parseCache *cache.Cache) ([]parseResult, error) {
+	results, err := parseAll(func(emit func(file string) error) error {
+		return s.ScanStream(paths, emit)
+	}, jobs, func(file string) parseResult {
+		return prefilterFile(file, parseCache)
+	}, nil)
+	if err != nil {
+		return nil, err
+	}
+
+	// Only classes with a new or delete in a parsed file can have findings
+	needed := make(map[string]bool)
+	for _, result := range results {
+		for i := range result.classes {
+			if class := &result.classes[i]; allocatesOrFrees(class) {
+				needed[class.Name] = true
+			}
+		}
+	}
+
+	var partners []string
+	var at []int
+	for i, result := range results {
+		if !result.skipped {
+			continue
+		}
+		for _, name := range result.names {
+			if needed[name] {
+				partners = append(partners, result.file)
+				at = append(at, i)
+				break
+			}
+		}
+	}
+	for i, result := range parseList(partners, jobs, parseCache, nil) {
+		result.index = at[i]
+		results[at[i]] = result
+	}
+	return results, nil
+}
+
+// prefilterFile parses a file if it contains new or delete, and otherwise
+// returns it as skipped with the class names it may define
+func prefilterFile(file string, parseCache *cache.Cache) parseResult {
+	result := parseResult{file: file}
+	content, release, err := parser.ReadSource(file)
+	if err != nil {
+		result.err = err
+		return result
+	}
+	defer release()
+	result.bytes = int64(len(content))
+
+	relevant, names := parser.Prescan(content)
+	if !relevant {
+		result.skipped = true
+		result.names = names
+		return result
+	}
+	parseContent(&result, content, parseCache, nil)
+	return result
+}
+
+// allocatesOrFrees reports whether any function of class has a new or delete
+func allocatesOrFrees(class *parser.Class) bool {
+	uses := func(fn *parser.Function) bool {
+		return fn != nil && (len(fn.Allocations) > 0 || len(fn.Deallocations) > 0)
+	}
+	if uses(class.Constructor) || uses(class.Destructor) {
+		return true
+	}
+	for i := range class.Methods {
+		if uses(&class.Methods[i]) {
+			return true
+		}
+	}
+	return false
+}
@@ -0,0 +1,92 @@
+package main
+
+import (
+	"fmt"
+	"os"
+	"runtime"
+	"runtime/pprof"
+	"runtime/trace"
+
+	"leakcheck/internal/stats"
+)
+
+// atExit holds the cleanups exit runs, most recent first
+var atExit []func()
+
+// exit runs the registered cleanups and exits. main uses it instead of
+// os.Exit once profiling may have started, so profiles are always complete.
+func exit(code int) {
+	for i := len(atExit) - 1; i >= 0; i-- {
+		atExit[i]()
+	}
+	os.Exit(code)
+}
+
+// startProfiles starts the CPU profile and execution trace, and arranges for
+// them and the heap profile to be written at exit. Empty paths are skipped.
+func startProfiles(cpuPath, memPath, tracePath string) error {
+	if cpuPath != "" {
+		f, err := os.Create(cpuPath)
+		if err != nil {
+			return fmt.Errorf("creating CPU profile: %w", err)
+		}
+		if err := pprof.StartCPUProfile(f); err != nil {
+			f.Close()
+			return fmt.Errorf("starting CPU profile: %w", err)
+		}
+		atExit = append(atExit, func() {
+			pprof.StopCPUProfile()
+			f.Close()
+		})
+	}
+
+	if tracePath != "" {
+		f, err := os.Create(tracePath)
+		if err != nil {
+			return fmt.Errorf("creating trace: %w", err)
+		}
+		if err := trace.Start(f); err != nil {
+			f.Close()
+			return fmt.Errorf("starting trace: %w", err)
+		}
+		atExit = append(atExit, func() {
+			trace.Stop()
+			f.Close()
+		})
+	}
+
+	if memPath != "" {
+		atExit = append(atExit, func() {
+			f, err := os.Create(memPath)
+			if err != nil {
+				fmt.Fprintf(os.Stderr, "Warning: creating heap profile: %v\n", err)
+				return
+			}
+			defer f.Close()
+			runtime.GC() // up-to-date statistics
+			if err := pprof.WriteHeapProfile(f); err != nil {
+				fmt.Fprintf(os.Stderr, "Warning: writing heap profile: %v\n", err)
+			}
+		})
+	}
+	return nil
+}
+
+// writeStats prints the stats report to stderr and/or writes it as JSON
+func writeStats(report stats.Report, text bool, jsonPath string) {
+	if text {
+		_ = report.WriteText(os.Stderr)
+	}
+	if jsonPath == "" {
+		return
+	}
+	f, err := os.Create(jsonPath)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Warning: writing stats: %v\n", err)
+		return
+	}
+	defer f.Close()
+	if err := report.WriteJSON(f); err != nil {
+		fmt.Fprintf(os.Stderr, "Warning: writing stats: %v\n", err)
+	}
+}
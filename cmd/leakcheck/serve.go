@@ -0,0 +1,601 @@
+package main
+
+import (
+	"bufio"
+	"encoding/json"
+	"errors"
+	"flag"
+	"fmt"
+	"io"
+	"net"
+	"os"
+	"os/signal"
+	"path/filepath"
+	"runtime"
+	"sort"
+	"strings"
+	"sync"
+	"syscall"
+	"time"
+
+	"leakcheck/internal/analyzer"
+	"leakcheck/internal/cache"
+	"leakcheck/internal/parser"
+	"leakcheck/internal/reporter"
+	"leakcheck/internal/scanner"
+)
+
+// defaultSocket is where serve listens and notify connects by default
+const defaultSocket = ".leakcheck.sock"
+
+// maxRequestSize bounds one request line on the serve socket
+const maxRequestSize = 16 << 20
+
+// serveRequest is one line sent to the serve socket.
+//
+//	{"method":"check"}                         all current findings
+//	{"method":"check","files":["a.cpp"]}       findings for classes defined in these files
+//	{"method":"changed","files":["a.cpp"]}     re-parse these files now; findings for the classes they touch
+//	{"method":"status"}                        file and class counts
+//	{"method":"shutdown"}                      stop the server
+type serveRequest struct {
+	Method string   `json:"method"`
+	Files  []string `json:"files,omitempty"`
+}
+
+// serveResponse is the line written back for each request
+type serveResponse struct {
+	Leaks     []parser.Leak    `json:"leaks"`
+	Summary   reporter.Summary `json:"summary"`
+	Files     int              `json:"files"`
+	Classes   int              `json:"classes"`
+	Reparsed  int              `json:"reparsed"`
+	ElapsedMS float64          `json:"elapsed_ms"`
+	Error     string           `json:"error,omitempty"`
+}
+
+// fileState is what the server keeps for one source file
+type fileState struct {
+	modTime time.Time
+	size    int64
+	seq     int // position in scan order, so merges match a full run
+	classes []parser.Class
+}
+
+// workspace is the in-memory index behind serve: the parsed classes of
+// every file, which files define each class, and the findings per class
+type workspace struct {
+	mu      sync.Mutex
+	scanner *scanner.Scanner
+	paths   []string
+	jobs    int
+	rules   []string // IDs of the rules to run
+	cache   *cache.Cache
+	files   map[string]*fileState
+	nextSeq int
+	// These are keyed by unqualified class name: the registry merges
+	// classes of one name across namespaces when a definition does not name
+	// its namespace, so all classes of a name are merged and analyzed together
+	definers map[string]map[string]bool // class name -> files defining it
+	leaks    map[string][]parser.Leak   // class name -> findings
+	merged   map[string]int             // class name -> classes after merging
+	classes  int                        // sum of merged
+}
+
+func newWorkspace(s *scanner.Scanner, paths []string, jobs int, parseCache *cache.Cache) *workspace {
+	absPaths := make([]string, len(paths))
+	for i, p := range paths {
+		absPaths[i], _ = filepath.Abs(p)
+	}
+	return &workspace{
+		scanner:  s,
+		paths:    absPaths,
+		jobs:     jobs,
+		rules:    analyzer.RuleIDs(),
+		cache:    parseCache,
+		files:    make(map[string]*fileState),
+		definers: make(map[string]map[string]bool),
+		leaks:    make(map[string][]parser.Leak),
+		merged:   make(map[string]int),
+	}
+}
+
+// poll walks the tree and re-parses new and modified files, and drops
+// deleted ones. It returns the number of files parsed.
+func (w *workspace) poll() (int, error) {
+	var current []string
+	if err := w.scanner.ScanStream(w.paths, func(file string) error {
+		current = append(current, file)
+		return nil
+	}); err != nil {
+		return 0, err
+	}
+
+	seen := make(map[string]bool, len(current))
+	var changed []string
+	for i, file := range current {
+		seen[file] = true
+		st := w.files[file]
+		info, err := os.Stat(file)
+		if err != nil {
+			continue
+		}
+		if st == nil || !st.modTime.Equal(info.ModTime()) || st.size != info.Size() {
+			changed = append(changed, file)
+		}
+		if st != nil {
+			st.seq = i
+		}
+	}
+	w.nextSeq = len(current)
+	for file := range w.files {
+		if !seen[file] {
+			changed = append(changed, file)
+		}
+	}
+	sort.Strings(changed)
+
+	_, reparsed := w.update(changed, current)
+	return reparsed, nil
+}
+
+// update re-reads files (absolute paths), re-merges and re-analyzes the
+// classes they define before and after, and returns their qualified names.
+// order, if not nil, is the scan order to assign to new files.
+func (w *workspace) update(files []string, order []string) (map[string]bool, int) {
+	position := make(map[string]int, len(order))
+	for i, file := range order {
+		position[file] = i
+	}
+
+	affected := make(map[string]bool)
+	var toParse []string
+	for _, file := range files {
+		// Files the scan just found were accepted by it already
+		_, scanned := position[file]
+		info, err := os.Stat(file)
+		if err != nil || info.IsDir() || !scanned && (!w.scanner.Accepts(file) || !underAny(file, w.paths)) {
+			// Deleted, or no longer part of the tree
+			if st := w.files[file]; st != nil {
+				w.forget(file, st, affected)
+				delete(w.files, file)
+			}
+			continue
+		}
+		toParse = append(toParse, file)
+	}
+
+	// Identifiers and paths interned by earlier batches are held by the
+	// classes that use them, so the table only needs this batch's names
+	if len(toParse) > 0 {
+		parser.Symbols.Reset()
+	}
+	for _, result := range parseList(toParse, w.jobs, w.cache, nil) {
+		st := w.files[result.file]
+		if st == nil {
+			st = &fileState{seq: w.nextSeq}
+			if i, ok := position[result.file]; ok {
+				st.seq = i
+			} else {
+				w.nextSeq++
+			}
+			w.files[result.file] = st
+		} else {
+			w.forget(result.file, st, affected)
+		}
+
+		if info, err := os.Stat(result.file); err == nil {
+			st.modTime, st.size = info.ModTime(), info.Size()
+		}
+		if reason, ok := limitReason(result.err); ok {
+			fmt.Fprintf(os.Stderr, "Warning: Skipping %s: %s\n", result.file, reason)
+			st.classes = nil
+			continue
+		}
+		if result.err != nil {
+			fmt.Fprintf(os.Stderr, "Warning: Error parsing %s: %v\n", result.file, result.err)
+			st.classes = nil
+			continue
+		}
+		st.classes = result.classes
+		for i := range st.classes {
+			name := st.classes[i].Name
+			affected[st.classes[i].QualifiedName()] = true
+			if w.definers[name] == nil {
+				w.definers[name] = make(map[string]bool)
+			}
+			w.definers[name][result.file] = true
+		}
+	}
+
+	w.reanalyze(affected)
+	return affected, len(toParse)
+}
+
+// forget removes a file's classes from the definers index, recording their
+// qualified names
+func (w *workspace) forget(file string, st *fileState, affected map[string]bool) {
+	for i := range st.classes {
+		name := st.classes[i].Name
+		affected[st.classes[i].QualifiedName()] = true
+		if defs := w.definers[name]; defs != nil {
+			delete(defs, file)
+			if len(defs) == 0 {
+				delete(w.definers, name)
+			}
+		}
+	}
+}
+
+// reanalyze merges every class named like one of names (qualified) from all
+// the files defining it, in scan order, and replaces their findings
+func (w *workspace) reanalyze(qualified map[string]bool) {
+	if len(qualified) == 0 {
+		return
+	}
+	names := make(map[string]bool, len(qualified))
+	for name := range qualified {
+		names[parser.BaseName(name)] = true
+	}
+
+	fileSet := make(map[string]bool)
+	for name := range names {
+		delete(w.leaks, name)
+		w.classes -= w.merged[name]
+		delete(w.merged, name)
+		for file := range w.definers[name] {
+			fileSet[file] = true
+		}
+	}
+	files := make([]string, 0, len(fileSet))
+	for file := range fileSet {
+		files = append(files, file)
+	}
+	sort.Slice(files, func(i, j int) bool { return w.files[files[i]].seq < w.files[files[j]].seq })
+
+	registry := parser.NewClassRegistry()
+	var selected []parser.Class
+	for _, file := range files {
+		selected = selected[:0]
+		for _, class := range w.files[file].classes {
+			if names[class.Name] {
+				selected = append(selected, class)
+			}
+		}
+		registry.AddClasses(selected)
+	}
+
+	merged := registry.MergeClasses()
+	for i := range merged {
+		w.merged[merged[i].Name]++
+	}
+	w.classes += len(merged)
+
+	a := newAnalyzer(w.jobs, w.rules)
+	a.AddClasses(merged)
+	a.AnalyzeEach(func(leaks []parser.Leak) {
+		for _, leak := range leaks {
+			name := parser.BaseName(leak.ClassName)
+			w.leaks[name] = append(w.leaks[name], leak)
+		}
+	})
+}
+
+// findings returns the findings for the classes in scope (qualified
+// names), or all of them if scope is nil, sorted by file and line
+func (w *workspace) findings(scope map[string]bool) []parser.Leak {
+	leaks := []parser.Leak{}
+	for _, classLeaks := range w.leaks {
+		for _, leak := range classLeaks {
+			if scope == nil || inScope(scope, leak.ClassName) {
+				leaks = append(leaks, leak)
+			}
+		}
+	}
+	sort.SliceStable(leaks, func(i, j int) bool {
+		if leaks[i].File != leaks[j].File {
+			return leaks[i].File < leaks[j].File
+		}
+		if leaks[i].Line != leaks[j].Line {
+			return leaks[i].Line < leaks[j].Line
+		}
+		return leaks[i].ClassName < leaks[j].ClassName
+	})
+	return leaks
+}
+
+// definedIn returns the qualified names of the classes defined in files
+func (w *workspace) definedIn(files []string) map[string]bool {
+	scope := make(map[string]bool)
+	for _, file := range files {
+		if st := w.files[file]; st != nil {
+			for i := range st.classes {
+				scope[st.classes[i].QualifiedName()] = true
+			}
+		}
+	}
+	return scope
+}
+
+// handle answers one request
+func (w *workspace) handle(req serveRequest) serveResponse {
+	start := time.Now()
+	w.mu.Lock()
+	defer w.mu.Unlock()
+
+	files := make([]string, len(req.Files))
+	for i, f := range req.Files {
+		files[i], _ = filepath.Abs(f)
+	}
+
+	var resp serveResponse
+	switch req.Method {
+	case "check":
+		var scope map[string]bool
+		if len(files) > 0 {
+			scope = w.definedIn(files)
+		}
+		resp.Leaks = w.findings(scope)
+	case "changed":
+		affected, reparsed := w.update(files, nil)
+		resp.Leaks = w.findings(affected)
+		resp.Reparsed = reparsed
+	case "status", "shutdown":
+		resp.Leaks = []parser.Leak{}
+	default:
+		resp.Leaks = []parser.Leak{}
+		resp.Error = fmt.Sprintf("unknown method %q", req.Method)
+	}
+
+	resp.Summary = reporter.Summarize(resp.Leaks)
+	resp.Files = len(w.files)
+	resp.Classes = w.classes
+	resp.ElapsedMS = float64(time.Since(start).Microseconds()) / 1000
+	return resp
+}
+
+// runServe implements "leakcheck serve": parse the tree once, keep it in
+// memory, and answer requests on a unix socket while polling for changes
+func runServe(args []string) {
+	fs := flag.NewFlagSet("serve", flag.ExitOnError)
+	socketFlag := fs.String("socket", defaultSocket, "Unix socket to listen on")
+	pollFlag := fs.Duration("poll", 2*time.Second, "How often to rescan the tree for changes; 0 disables polling")
+	excludeFlag := fs.String("exclude", "", "Comma-separated list of directories to exclude")
+	noIgnoreFlag := fs.Bool("no-ignore", false, "Scan files matched by .gitignore and .leakcheckignore files too")
+	maxBytesFlag := fs.Int("max-file-bytes", 0, "Skip files larger than this many bytes; 0 is unlimited")
+	maxTokensFlag := fs.Int("max-file-tokens", 0, "Skip files with more than this many tokens; 0 is unlimited")
+	parseTimeoutFlag := fs.Duration("parse-timeout", 0, "Skip files that take longer than this to parse; 0 is unlimited")
+	jobsFlag := fs.Int("jobs", runtime.GOMAXPROCS(0), "Number of parallel workers for parsing and analysis")
+	rulesFlag := fs.String("rules", "", "Comma-separated list of rules to run (default: all)")
+	disableRuleFlag := fs.String("disable-rule", "", "Comma-separated list of rules not to run")
+	cacheFlag := fs.String("cache-dir", "", "Directory for the parse cache; disabled if empty")
+	fs.Usage = func() {
+		fmt.Fprintf(os.Stderr, "Usage: leakcheck serve [options] <path> [paths...]\n\n")
+		fmt.Fprintf(os.Stderr, "Keep the parsed tree in memory and serve findings on a unix socket.\n")
+		fmt.Fprintf(os.Stderr, "Requests and responses are one JSON object per line; see README.md.\n\n")
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		fs.PrintDefaults()
+	}
+	fs.Parse(args)
+
+	paths := fs.Args()
+	if len(paths) == 0 {
+		fmt.Fprintln(os.Stderr, "Error: No paths specified")
+		os.Exit(1)
+	}
+
+	limits = parser.Limits{MaxBytes: *maxBytesFlag, MaxTokens: *maxTokensFlag, Timeout: *parseTimeoutFlag}
+	// Editors truncate and rewrite files in place while the server reads
+	// them; with a shared mapping that would crash it with SIGBUS
+	parser.UseMmap = false
+	ruleIDs, err := selectRules(*rulesFlag, *disableRuleFlag)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		os.Exit(1)
+	}
+
+	var parseCache *cache.Cache
+	if *cacheFlag != "" {
+		var err error
+		parseCache, err = cache.New(*cacheFlag, version)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error opening cache: %v\n", err)
+			os.Exit(1)
+		}
+	}
+
+	s := scanner.NewScanner(splitList(*excludeFlag))
+	s.IgnoreFiles = !*noIgnoreFlag
+	w := newWorkspace(s, paths, *jobsFlag, parseCache)
+	w.rules = ruleIDs
+	start := time.Now()
+	parsed, err := w.poll()
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error scanning paths: %v\n", err)
+		os.Exit(1)
+	}
+	fmt.Fprintf(os.Stderr, "Indexed %d file(s), %d class(es) in %s\n", parsed, w.classes, time.Since(start).Round(time.Millisecond))
+
+	listener, err := listenUnix(*socketFlag)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		os.Exit(1)
+	}
+	fmt.Fprintf(os.Stderr, "Listening on %s\n", *socketFlag)
+
+	done := make(chan struct{})
+	var once sync.Once
+	stop := func() { once.Do(func() { close(done); listener.Close() }) }
+
+	signals := make(chan os.Signal, 1)
+	signal.Notify(signals, os.Interrupt, syscall.SIGTERM)
+	go func() {
+		select {
+		case <-signals:
+			stop()
+		case <-done:
+		}
+	}()
+
+	if *pollFlag > 0 {
+		go func() {
+			ticker := time.NewTicker(*pollFlag)
+			defer ticker.Stop()
+			for {
+				select {
+				case <-done:
+					return
+				case <-ticker.C:
+					w.mu.Lock()
+					if _, err := w.poll(); err != nil {
+						fmt.Fprintf(os.Stderr, "Warning: rescanning: %v\n", err)
+					}
+					w.mu.Unlock()
+				}
+			}
+		}()
+	}
+
+	for {
+		conn, err := listener.Accept()
+		if err != nil {
+			select {
+			case <-done:
+				os.Remove(*socketFlag)
+				return
+			default:
+			}
+			fmt.Fprintf(os.Stderr, "Warning: accepting connection: %v\n", err)
+			continue
+		}
+		go serveConn(conn, w, stop)
+	}
+}
+
+// serveConn answers requests on one connection until it is closed
+func serveConn(conn net.Conn, w *workspace, stop func()) {
+	defer conn.Close()
+	lines := bufio.NewScanner(conn)
+	lines.Buffer(make([]byte, 64*1024), maxRequestSize)
+	out := bufio.NewWriter(conn)
+	encoder := json.NewEncoder(out)
+
+	for lines.Scan() {
+		var req serveRequest
+		var resp serveResponse
+		if err := json.Unmarshal(lines.Bytes(), &req); err != nil {
+			resp = serveResponse{Leaks: []parser.Leak{}, Error: "invalid request: " + err.Error()}
+		} else {
+			resp = w.handle(req)
+		}
+		if encoder.Encode(resp) != nil || out.Flush() != nil {
+			return
+		}
+		if req.Method == "shutdown" {
+			stop()
+			return
+		}
+	}
+}
+
+// listenUnix listens on a unix socket, replacing a stale socket file left
+// behind by a server that is no longer running
+func listenUnix(path string) (net.Listener, error) {
+	listener, err := net.Listen("unix", path)
+	if err == nil {
+		return listener, nil
+	}
+	if conn, dialErr := net.Dial("unix", path); dialErr == nil {
+		conn.Close()
+		return nil, fmt.Errorf("a server is already listening on %s", path)
+	}
+	if _, statErr := os.Stat(path); statErr != nil {
+		return nil, err
+	}
+	if rmErr := os.Remove(path); rmErr != nil {
+		return nil, err
+	}
+	return net.Listen("unix", path)
+}
+
+// runNotify implements "leakcheck notify": tell a running server that files
+// changed (or just ask for findings) and print the answer like a normal run
+func runNotify(args []string) {
+	fs := flag.NewFlagSet("notify", flag.ExitOnError)
+	socketFlag := fs.String("socket", defaultSocket, "Unix socket of the running server")
+	jsonFlag := fs.Bool("json", false, "Print the server's response as JSON")
+	fs.Usage = func() {
+		fmt.Fprintf(os.Stderr, "Usage: leakcheck notify [options] [changed files...]\n\n")
+		fmt.Fprintf(os.Stderr, "With files, the server re-parses them and reports the classes they touch.\n")
+		fmt.Fprintf(os.Stderr, "Without files, it reports all current findings.\n\n")
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		fs.PrintDefaults()
+	}
+	fs.Parse(args)
+
+	req := serveRequest{Method: "check"}
+	if fs.NArg() > 0 {
+		req = serveRequest{Method: "changed", Files: fs.Args()}
+	}
+
+	resp, err := callServer(*socketFlag, req)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		os.Exit(2)
+	}
+	if resp.Error != "" {
+		fmt.Fprintf(os.Stderr, "Error: %s\n", resp.Error)
+		os.Exit(2)
+	}
+
+	if *jsonFlag {
+		encoder := json.NewEncoder(os.Stdout)
+		encoder.SetIndent("", "  ")
+		encoder.Encode(resp)
+	} else if err := reporter.NewReporter(os.Stdout, reporter.FormatConsole).Report(resp.Leaks); err != nil {
+		fmt.Fprintf(os.Stderr, "Error writing report: %v\n", err)
+		os.Exit(2)
+	}
+	if len(resp.Leaks) > 0 {
+		os.Exit(1)
+	}
+}
+
+// callServer sends one request and reads the response
+func callServer(socket string, req serveRequest) (serveResponse, error) {
+	var resp serveResponse
+	for i, f := range req.Files {
+		req.Files[i], _ = filepath.Abs(f)
+	}
+
+	conn, err := net.Dial("unix", socket)
+	if err != nil {
+		return resp, fmt.Errorf("no server on %s (start one with 'leakcheck serve'): %w", socket, err)
+	}
+	defer conn.Close()
+
+	if err := json.NewEncoder(conn).Encode(req); err != nil {
+		return resp, err
+	}
+	// Responses carry every finding, so unlike requests they are not
+	// bounded by maxRequestSize
+	if err := json.NewDecoder(conn).Decode(&resp); err != nil {
+		if err == io.EOF {
+			return resp, errors.New("server closed the connection")
+		}
+		return resp, err
+	}
+	return resp, nil
+}
+
+// splitList splits a comma-separated flag value, trimming spaces
+func splitList(value string) []string {
+	if value == "" {
+		return nil
+	}
+	items := strings.Split(value, ",")
+	for i := range items {
+		items[i] = strings.TrimSpace(items[i])
+	}
+	return items
+}
@@ -0,0 +1,143 @@
+package main
+
+import (
+	"flag"
+	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
+
+	"leakcheck/internal/cache"
+	"leakcheck/internal/parser"
+	"leakcheck/internal/reporter"
+	"leakcheck/internal/scanner"
+	"leakcheck/internal/shard"
+	"leakcheck/internal/stats"
+)
+
+// writeShard parses the files of paths that belong to spec and writes them
+// to out as a shard dump. It returns the number of files parsed and the
+// number scanned across all shards.
+func writeShard(s *scanner.Scanner, paths []string, spec shard.Spec, out string, jobs int, parseCache *cache.Cache, st *stats.Collector) (int, int, error) {
+	// Every shard walks the whole tree, so each file keeps its position in
+	// the full scan order and the merge can replay it
+	var positions []int
+	total := 0
+	roots := make([]string, len(paths))
+	for i, p := range paths {
+		roots[i], _ = filepath.Abs(p)
+	}
+	results, err := parseAll(func(emit func(file string) error) error {
+		return s.ScanStream(paths, func(file string) error {
+			total++
+			if !spec.Owns(shard.Key(file, roots)) {
+				return nil
+			}
+			positions = append(positions, total-1)
+			return emit(file)
+		})
+	}, jobs, func(file string) parseResult {
+		return parseFile(file, parseCache, nil)
+	}, nil)
+	if err != nil {
+		return 0, 0, fmt.Errorf("scanning paths: %w", err)
+	}
+
+	dump := shard.NewDump(spec, version, paths)
+	dump.Files = total
+	dump.Entries = make([]shard.Entry, len(results))
+	for i, result := range results {
+		entry := shard.Entry{Index: positions[i], File: result.file, Classes: result.classes}
+		if reason, ok := limitReason(result.err); ok {
+			fmt.Fprintf(os.Stderr, "Warning: Skipping %s: %s\n", result.file, reason)
+			st.LimitFile(result.file, reason)
+			entry.Skipped = reason
+		} else if result.err != nil {
+			entry.Error = result.err.Error()
+		} else {
+			st.AddFile(result.fileStats())
+		}
+		dump.Entries[i] = entry
+	}
+	if err := dump.Write(out); err != nil {
+		return 0, 0, fmt.Errorf("writing shard dump: %w", err)
+	}
+	return len(results), total, nil
+}
+
+// runMerge combines the dumps written by --shard runs and reports the
+// findings across all of them
+func runMerge(args []string) {
+	fs := flag.NewFlagSet("merge", flag.ExitOnError)
+	jsonFlag := fs.Bool("json", false, "Output results in JSON format (same as --format=json)")
+	formatFlag := fs.String("format", "console", "Output format: console, json, ndjson or sarif")
+	jobsFlag := fs.Int("jobs", runtime.GOMAXPROCS(0), "Number of parallel workers for analysis")
+	maxFindingsFlag := fs.Int("max-findings", 0, "Show at most this many findings per file in console output; 0 shows all")
+	rulesFlag := fs.String("rules", "", "Comma-separated list of rules to run (default: all)")
+	disableRuleFlag := fs.String("disable-rule", "", "Comma-separated list of rules not to run")
+	fs.Usage = func() {
+		fmt.Fprintf(os.Stderr, "Usage: leakcheck merge [options] <shard dumps...>\n\n")
+		fmt.Fprintf(os.Stderr, "Merges the dumps of every 'leakcheck --shard=i/N' run of one scan and\n")
+		fmt.Fprintf(os.Stderr, "analyzes the combined classes.\n\n")
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		fs.PrintDefaults()
+	}
+	fs.Parse(args)
+
+	if fs.NArg() == 0 {
+		fmt.Fprintln(os.Stderr, "Error: No shard dumps specified")
+		os.Exit(1)
+	}
+	format, err := resolveFormat(*formatFlag, *jsonFlag)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		os.Exit(1)
+	}
+	ruleIDs, err := selectRules(*rulesFlag, *disableRuleFlag)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		os.Exit(1)
+	}
+
+	var dumps []*shard.Dump
+	for _, path := range fs.Args() {
+		dump, err := shard.Read(path)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error reading shard dump: %v\n", err)
+			os.Exit(1)
+		}
+		dumps = append(dumps, dump)
+	}
+	entries, err := shard.Merge(dumps)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		os.Exit(1)
+	}
+
+	if format == reporter.FormatConsole {
+		fmt.Printf("Merging %d shard(s) of %d file(s)...\n", len(dumps), len(entries))
+	}
+
+	// Register in scan order, as a single run would
+	registry := parser.NewClassRegistry()
+	for _, entry := range entries {
+		if entry.Skipped != "" {
+			fmt.Fprintf(os.Stderr, "Warning: Skipping %s: %s\n", entry.File, entry.Skipped)
+			continue
+		}
+		if entry.Error != "" {
+			fmt.Fprintf(os.Stderr, "Warning: Error parsing %s: %s\n", entry.File, entry.Error)
+			continue
+		}
+		registry.AddClasses(entry.Classes)
+	}
+	allClasses := registry.MergeClasses()
+
+	if format == reporter.FormatConsole {
+		fmt.Printf("Found %d class(es) with pointer members\n", countClassesWithPointers(allClasses))
+	}
+
+	if analyzeAndReport(allClasses, format, *jobsFlag, *maxFindingsFlag, ruleIDs, nil, nil) > 0 {
+		os.Exit(1)
+	}
+}
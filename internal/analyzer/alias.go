@@ -0,0 +1,106 @@
+package analyzer
+
+import "leakcheck/internal/parser"
+
+// aliasSets groups the variables of a class that may point to the same memory.
+// Every `a = b;` pointer assignment joins the sets of a and b within its
+// function, so chains like `a = b; b = c;` put a, b and c in one set. Sets do
+// not span functions: a local such as tmp is different memory in each one,
+// and joining `tmp = m_a;` in one method with `tmp = m_b;` in another would let
+// the delete of m_a hide a leak of m_b.
+type aliasSets struct {
+	nodes  map[string][]int32 // variable name -> its ID in each function aliasing it
+	names  []string           // ID -> variable name
+	parent []int32            // union-find forest over IDs
+	freed  []int32            // root ID -> lowest freed member ID, or -1
+}
+
+// buildAliasSets makes one linear pass over the aliases of the constructor,
+// destructor and methods of class
+func buildAliasSets(class *parser.Class) *aliasSets {
+	s := &aliasSets{nodes: make(map[string][]int32)}
+
+	local := make(map[string]int32) // variable name -> ID in the current function
+	intern := func(name string) int32 {
+		if id, ok := local[name]; ok {
+			return id
+		}
+		id := int32(len(s.names))
+		local[name] = id
+		s.nodes[name] = append(s.nodes[name], id)
+		s.names = append(s.names, name)
+		s.parent = append(s.parent, id)
+		return id
+	}
+	addFunc := func(fn *parser.Function) {
+		if fn == nil || len(fn.Aliases) == 0 {
+			return
+		}
+		clear(local)
+		for _, alias := range fn.Aliases {
+			s.union(intern(alias.SourceVar), intern(alias.TargetVar))
+		}
+	}
+
+	addFunc(class.Constructor)
+	addFunc(class.Destructor)
+	for i := range class.Methods {
+		addFunc(&class.Methods[i])
+	}
+
+	return s
+}
+
+// find returns the root of id's set, halving the path as it goes
+func (s *aliasSets) find(id int32) int32 {
+	for s.parent[id] != id {
+		s.parent[id] = s.parent[s.parent[id]]
+		id = s.parent[id]
+	}
+	return id
+}
+
+// union merges the sets of a and b, keeping the lower ID as the root
+func (s *aliasSets) union(a, b int32) {
+	ra, rb := s.find(a), s.find(b)
+	if ra == rb {
+		return
+	}
+	if rb < ra {
+		ra, rb = rb, ra
+	}
+	s.parent[rb] = ra
+}
+
+// markFreed records, for every set, its first member freed in deallocs
+func (s *aliasSets) markFreed(deallocs deallocSet) {
+	s.freed = make([]int32, len(s.names))
+	for i := range s.freed {
+		s.freed[i] = -1
+	}
+	if len(deallocs) == 0 {
+		return
+	}
+	for id, name := range s.names {
+		if _, ok := deallocs[name]; !ok {
+			continue
+		}
+		if root := s.find(int32(id)); s.freed[root] < 0 {
+			s.freed[root] = int32(id)
+		}
+	}
+}
+
+// deallocation returns the deallocation that frees varName, either directly or
+// through any variable in one of its alias sets. markFreed must have been called with deallocs.
+func (s *aliasSets) deallocation(varName string, deallocs deallocSet) (parser.Deallocation, bool) {
+	if dealloc, ok := deallocs[varName]; ok {
+		return dealloc, true
+	}
+	for _, id := range s.nodes[varName] {
+		if freed := s.freed[s.find(id)]; freed >= 0 {
+			return deallocs[s.names[freed]], true
+		}
+	}
+	return parser.Deallocation{}, false
+}
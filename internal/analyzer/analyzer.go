@@ -3,302 +3,222 @@ package analyzer
 import (
 	"fmt"
 	"leakcheck/internal/parser"
+	"runtime"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
 )
 
-// MaxMethodDepth is the maximum depth to follow method calls
-const MaxMethodDepth = 5
+// shardSize is the number of consecutive classes a worker claims at a time
+const shardSize = 64
 
 // Analyzer detects memory leaks in parsed C++ classes
 type Analyzer struct {
-	classes []parser.Class
+	classes  []parser.Class
+	workers  int
+	pipeline []rule       // enabled rules, in registration order
+	times    []ruleTotals // per pipeline rule; nil unless timing is on
 }
 
-// NewAnalyzer creates a new analyzer
-func NewAnalyzer() *Analyzer {
-	return &Analyzer{}
+// ruleTime is the cost of one rule over some classes
+type ruleTime struct {
+	elapsed  time.Duration
+	findings int
 }
 
-// AddClasses adds parsed classes to analyze
-func (a *Analyzer) AddClasses(classes []parser.Class) {
-	a.classes = append(a.classes, classes...)
+// ruleTotals is the cost of one rule over all classes analyzed so far
+type ruleTotals struct {
+	elapsed  atomic.Int64
+	findings atomic.Int64
 }
 
-// Analyze performs leak detection and returns found issues
-func (a *Analyzer) Analyze() []parser.Leak {
-	var leaks []parser.Leak
-
-	for _, class := range a.classes {
-		classLeaks := a.analyzeClass(class)
-		leaks = append(leaks, classLeaks...)
-	}
-
-	return leaks
+// RuleStat is the time one rule took, summed over all workers, and the
+// number of findings it produced
+type RuleStat struct {
+	ID       string
+	Duration time.Duration
+	Findings int
 }
 
-func (a *Analyzer) analyzeClass(class parser.Class) []parser.Leak {
-	var leaks []parser.Leak
+// NewAnalyzer creates a new analyzer that runs every rule
+func NewAnalyzer() *Analyzer {
+	return &Analyzer{workers: runtime.GOMAXPROCS(0), pipeline: rules}
+}
 
-	// Get all pointer members
-	pointerMembers := make(map[string]parser.Member)
-	for _, m := range class.Members {
-		if m.IsPointer {
-			pointerMembers[m.Name] = m
+// SetRules limits the analysis to the rules with the given IDs. Findings
+// are still reported in registration order, whatever the order of ids.
+func (a *Analyzer) SetRules(ids []string) error {
+	enabled := make(map[string]bool, len(ids))
+	for _, id := range ids {
+		enabled[id] = true
+	}
+	var pipeline []rule
+	for _, r := range rules {
+		if enabled[r.id] {
+			pipeline = append(pipeline, r)
+			delete(enabled, r.id)
 		}
 	}
-
-	if len(pointerMembers) == 0 {
-		return nil
-	}
-
-	// Track allocations in constructor
-	allocatedVars := make(map[string]parser.Allocation)
-	if class.Constructor != nil {
-		for _, alloc := range class.Constructor.Allocations {
-			allocatedVars[alloc.VarName] = alloc
+	for _, id := range ids {
+		if enabled[id] {
+			return fmt.Errorf("unknown rule %q (known rules: %s)", id, strings.Join(RuleIDs(), ", "))
 		}
 	}
-
-	// Build method map for quick lookup
-	methodMap := make(map[string]*parser.Function)
-	for i := range class.Methods {
-		methodMap[class.Methods[i].Name] = &class.Methods[i]
+	a.pipeline = pipeline
+	if a.times != nil {
+		a.times = make([]ruleTotals, len(pipeline))
 	}
+	return nil
+}
 
-	// Track deallocations in destructor using MULTI-LEVEL method tracking
-	deallocatedVars := make(map[string]parser.Deallocation)
-	aliasMap := buildAliasMap(class) // Build pointer alias map
-
-	if class.Destructor != nil {
-		// Collect all deallocations recursively (multi-level)
-		collectDeallocations(class.Destructor, methodMap, deallocatedVars, MaxMethodDepth, make(map[string]bool))
+// SetTiming turns on timing each rule, reported by RuleStats
+func (a *Analyzer) SetTiming(on bool) {
+	a.times = nil
+	if on {
+		a.times = make([]ruleTotals, len(a.pipeline))
 	}
+}
 
-	// Rule 1: Allocated in constructor but not deleted in destructor
-	for varName, alloc := range allocatedVars {
-		// Check direct delete or delete through alias
-		deleted := isVarDeallocated(varName, deallocatedVars, aliasMap)
-
-		if !deleted {
-			deleteOp := "delete"
-			if alloc.IsArray {
-				deleteOp = "delete[]"
-			}
-			leaks = append(leaks, parser.Leak{
-				File:           class.File,
-				Line:           alloc.Line,
-				ClassName:      class.Name,
-				VarName:        varName,
-				Reason:         "allocated with 'new' but not deleted in destructor",
-				Severity:       "error",
-				Recommendation: "In destructor ~" + class.Name + "(), add: " + deleteOp + " " + varName + "; // prevents memory leak from line " + fmt.Sprintf("%d", alloc.Line),
-			})
-		} else {
-			// Check for array mismatch
-			dealloc := findDeallocation(varName, deallocatedVars, aliasMap)
-			if dealloc != nil {
-				if alloc.IsArray && !dealloc.IsArray {
-					leaks = append(leaks, parser.Leak{
-						File:           class.File,
-						Line:           dealloc.Line,
-						ClassName:      class.Name,
-						VarName:        varName,
-						Reason:         "allocated with 'new[]' but deleted with 'delete' instead of 'delete[]'",
-						Severity:       "error",
-						Recommendation: fmt.Sprintf("At line %d, change 'delete %s' to 'delete[] %s'. Using delete on array allocations causes undefined behavior.", dealloc.Line, varName, varName),
-					})
-				} else if !alloc.IsArray && dealloc.IsArray {
-					leaks = append(leaks, parser.Leak{
-						File:           class.File,
-						Line:           dealloc.Line,
-						ClassName:      class.Name,
-						VarName:        varName,
-						Reason:         "allocated with 'new' but deleted with 'delete[]' instead of 'delete'",
-						Severity:       "warning",
-						Recommendation: fmt.Sprintf("At line %d, change 'delete[] %s' to 'delete %s'. Single object allocated with 'new' should use 'delete'.", dealloc.Line, varName, varName),
-					})
-				}
-			}
-		}
+// RuleStats returns the cost of each enabled rule so far, in pipeline
+// order, or nil unless timing is on
+func (a *Analyzer) RuleStats() []RuleStat {
+	if a.times == nil {
+		return nil
 	}
-
-	// Rule 2: Pointer reassignment without prior delete in methods
-	for _, method := range class.Methods {
-		for _, alloc := range method.Allocations {
-			if _, exists := pointerMembers[alloc.VarName]; exists {
-				// Check if this variable is deallocated before reassignment in the same method
-				hasDeleteBeforeNew := false
-				for _, dealloc := range method.Deallocations {
-					if dealloc.VarName == alloc.VarName && dealloc.Line < alloc.Line {
-						hasDeleteBeforeNew = true
-						break
-					}
-				}
-
-				if !hasDeleteBeforeNew {
-					// Check if there's an existing allocation (reassignment without delete)
-					if _, wasAllocatedInCtor := allocatedVars[alloc.VarName]; wasAllocatedInCtor {
-						leaks = append(leaks, parser.Leak{
-							File:           class.File,
-							Line:           alloc.Line,
-							ClassName:      class.Name,
-							VarName:        alloc.VarName,
-							Reason:         "pointer reassigned with 'new' without deleting previous allocation (in " + method.Name + ")",
-							Severity:       "warning",
-							Recommendation: fmt.Sprintf("Before line %d in %s::%s(), add: delete %s; // Or consider using std::unique_ptr<%s> for automatic memory management", alloc.Line, class.Name, method.Name, alloc.VarName, "T"),
-						})
-					}
-				}
-			}
+	out := make([]RuleStat, len(a.pipeline))
+	for i, r := range a.pipeline {
+		out[i] = RuleStat{
+			ID:       r.id,
+			Duration: time.Duration(a.times[i].elapsed.Load()),
+			Findings: int(a.times[i].findings.Load()),
 		}
 	}
+	return out
+}
 
-	// Rule 3: Pointer aliasing - delete through alias is valid, but warn about potential issues
-	for _, method := range class.Methods {
-		for _, alias := range method.Aliases {
-			if _, isPointerMember := pointerMembers[alias.SourceVar]; isPointerMember {
-				// Check if target is later deleted but source is also deleted (double delete)
-				sourceDeleted := false
-				targetDeleted := false
-				for _, dealloc := range method.Deallocations {
-					if dealloc.VarName == alias.SourceVar {
-						sourceDeleted = true
-					}
-					if dealloc.VarName == alias.TargetVar {
-						targetDeleted = true
-					}
-				}
-				if sourceDeleted && targetDeleted {
-					leaks = append(leaks, parser.Leak{
-						File:           class.File,
-						Line:           alias.Line,
-						ClassName:      class.Name,
-						VarName:        alias.SourceVar,
-						Reason:         "pointer aliased to '" + alias.TargetVar + "' and both are deleted (potential double-free)",
-						Severity:       "error",
-						Recommendation: fmt.Sprintf("Double-free detected: '%s' and '%s' point to same memory. Remove one delete, or set '%s = nullptr;' after first delete to prevent crash.", alias.SourceVar, alias.TargetVar, alias.SourceVar),
-					})
-				}
-			}
-		}
+// SetWorkers sets the number of goroutines used by Analyze
+func (a *Analyzer) SetWorkers(n int) {
+	if n < 1 {
+		n = 1
 	}
+	a.workers = n
+}
 
-	// Rule 4: No destructor but has allocations
-	if class.Destructor == nil {
-		for _, member := range pointerMembers {
-			if _, allocated := allocatedVars[member.Name]; allocated {
-				alloc := allocatedVars[member.Name]
-				deleteOp := "delete"
-				if alloc.IsArray {
-					deleteOp = "delete[]"
-				}
-				leaks = append(leaks, parser.Leak{
-					File:           class.File,
-					Line:           member.Line,
-					ClassName:      class.Name,
-					VarName:        member.Name,
-					Reason:         "pointer member allocated but class has no destructor",
-					Severity:       "error",
-					Recommendation: fmt.Sprintf("Add destructor to class %s: ~%s() { %s %s; %s = nullptr; }", class.Name, class.Name, deleteOp, member.Name, member.Name),
-				})
-			}
-		}
-	}
+// AddClasses adds parsed classes to analyze
+func (a *Analyzer) AddClasses(classes []parser.Class) {
+	a.classes = append(a.classes, classes...)
+}
 
+// Analyze performs leak detection and returns found issues.
+// Classes are analyzed in parallel in shards of consecutive classes; the
+// result is the same, in the same order, as analyzing them one by one.
+func (a *Analyzer) Analyze() []parser.Leak {
+	var leaks []parser.Leak
+	a.AnalyzeEach(func(shardLeaks []parser.Leak) {
+		leaks = append(leaks, shardLeaks...)
+	})
 	return leaks
 }
 
-// collectDeallocations recursively collects deallocations from a function and its called methods
-func collectDeallocations(fn *parser.Function, methodMap map[string]*parser.Function,
-	result map[string]parser.Deallocation, depth int, visited map[string]bool) {
-
-	if depth <= 0 || fn == nil {
-		return
-	}
-
-	// Prevent infinite recursion
-	if visited[fn.Name] {
+// AnalyzeEach performs leak detection and passes the issues to emit shard by
+// shard, in class order, as soon as each shard and all earlier ones are done.
+// emit is called from the calling goroutine and never with an empty slice.
+func (a *Analyzer) AnalyzeEach(emit func(leaks []parser.Leak)) {
+	shards := (len(a.classes) + shardSize - 1) / shardSize
+	workers := a.workers
+	if workers > shards {
+		workers = shards
+	}
+	if workers <= 1 {
+		for start := 0; start < len(a.classes); start += shardSize {
+			end := min(start+shardSize, len(a.classes))
+			if leaks := a.analyzeRange(start, end, nil); len(leaks) > 0 {
+				emit(leaks)
+			}
+		}
 		return
 	}
-	visited[fn.Name] = true
-
-	// Add direct deallocations
-	for _, dealloc := range fn.Deallocations {
-		result[dealloc.VarName] = dealloc
-	}
 
-	// Recurse into called methods
-	for _, methodName := range fn.MethodCalls {
-		if calledMethod, exists := methodMap[methodName]; exists {
-			collectDeallocations(calledMethod, methodMap, result, depth-1, visited)
+	type shardResult struct {
+		shard int
+		leaks []parser.Leak
+	}
+	done := make(chan shardResult, workers)
+	var next atomic.Int64
+	var wg sync.WaitGroup
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for {
+				shard := int(next.Add(1) - 1)
+				if shard >= shards {
+					return
+				}
+				start := shard * shardSize
+				end := min(start+shardSize, len(a.classes))
+				done <- shardResult{shard: shard, leaks: a.analyzeRange(start, end, nil)}
+			}
+		}()
+	}
+	go func() {
+		wg.Wait()
+		close(done)
+	}()
+
+	// Reorder: hold finished shards until every earlier shard is in
+	results := make([][]parser.Leak, shards)
+	finished := make([]bool, shards)
+	ready := 0
+	for result := range done {
+		results[result.shard] = result.leaks
+		finished[result.shard] = true
+		for ready < shards && finished[ready] {
+			if len(results[ready]) > 0 {
+				emit(results[ready])
+			}
+			results[ready] = nil
+			ready++
 		}
 	}
 }
 
-// buildAliasMap creates a map of source -> targets for pointer aliases
-func buildAliasMap(class parser.Class) map[string][]string {
-	aliasMap := make(map[string][]string)
-
-	// Collect aliases from all functions
-	collectAliasesFromFunc := func(fn *parser.Function) {
-		if fn == nil {
-			return
-		}
-		for _, alias := range fn.Aliases {
-			aliasMap[alias.SourceVar] = append(aliasMap[alias.SourceVar], alias.TargetVar)
-			// Also reverse: if we delete target, it's like deleting source
-			aliasMap[alias.TargetVar] = append(aliasMap[alias.TargetVar], alias.SourceVar)
-		}
-	}
-
-	if class.Constructor != nil {
-		collectAliasesFromFunc(class.Constructor)
-	}
-	if class.Destructor != nil {
-		collectAliasesFromFunc(class.Destructor)
+// analyzeRange appends the leaks of a.classes[start:end] to leaks
+func (a *Analyzer) analyzeRange(start, end int, leaks []parser.Leak) []parser.Leak {
+	var times []ruleTime
+	if a.times != nil {
+		times = make([]ruleTime, len(a.pipeline))
 	}
-	for i := range class.Methods {
-		collectAliasesFromFunc(&class.Methods[i])
+	for i := start; i < end; i++ {
+		leaks = a.analyzeClass(&a.classes[i], leaks, times)
 	}
-
-	return aliasMap
-}
-
-// isVarDeallocated checks if a variable is deallocated directly or through an alias
-func isVarDeallocated(varName string, deallocatedVars map[string]parser.Deallocation, aliasMap map[string][]string) bool {
-	// Direct check
-	if _, deleted := deallocatedVars[varName]; deleted {
-		return true
-	}
-
-	// Check aliases
-	if aliases, hasAliases := aliasMap[varName]; hasAliases {
-		for _, aliasName := range aliases {
-			if _, deleted := deallocatedVars[aliasName]; deleted {
-				return true
-			}
-		}
+	// Timings are summed per shard, so workers rarely contend on the totals
+	for i, t := range times {
+		a.times[i].elapsed.Add(int64(t.elapsed))
+		a.times[i].findings.Add(int64(t.findings))
 	}
-
-	return false
+	return leaks
 }
 
-// findDeallocation finds the deallocation for a variable (direct or through alias)
-func findDeallocation(varName string, deallocatedVars map[string]parser.Deallocation, aliasMap map[string][]string) *parser.Deallocation {
-	// Direct check
-	if dealloc, deleted := deallocatedVars[varName]; deleted {
-		return &dealloc
-	}
-
-	// Check aliases
-	if aliases, hasAliases := aliasMap[varName]; hasAliases {
-		for _, aliasName := range aliases {
-			if dealloc, deleted := deallocatedVars[aliasName]; deleted {
-				return &dealloc
-			}
+// analyzeClass appends the findings of the enabled rules on class to
+// leaks, adding each rule's cost to times when timing is on
+func (a *Analyzer) analyzeClass(class *parser.Class, leaks []parser.Leak, times []ruleTime) []parser.Leak {
+	ix := newClassIndex(class)
+	if ix == nil {
+		return leaks
+	}
+	for i, r := range a.pipeline {
+		if times == nil {
+			leaks = r.check(ix, leaks)
+			continue
 		}
+		start, n := time.Now(), len(leaks)
+		leaks = r.check(ix, leaks)
+		times[i].elapsed += time.Since(start)
+		times[i].findings += len(leaks) - n
 	}
-
-	return nil
+	return leaks
 }
 
 // AnalyzeClasses is a convenience function to analyze classes directly
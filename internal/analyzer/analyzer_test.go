@@ -0,0 +1,210 @@
+package analyzer
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"slices"
+	"testing"
+
+	"leakcheck/internal/corpus"
+	"leakcheck/internal/parser"
+)
+
+// analyzeSource parses and analyzes one file, returning "rule var:line"
+// for each finding
+func analyzeSource(t *testing.T, src string) []string {
+	t.Helper()
+	var got []string
+	for _, leak := range AnalyzeClasses(parser.ParseSource("/src/test.cpp", []byte(src))) {
+		got = append(got, fmt.Sprintf("%s %s:%d", leak.Rule, leak.VarName, leak.Line))
+	}
+	return got
+}
+
+func TestRules(t *testing.T) {
+	for _, tc := range []struct {
+		name string
+		src  string
+		want []string
+	}{
+		{
+			name: "clean",
+			src: `class A { int *p;
+public:
+  A() { p = new int; }
+  ~A() { delete p; }
+};`,
+		},
+		{
+			name: "missing delete",
+			src: `class A { int *p; int *q;
+public:
+  A() { p = new int; q = new int; }
+  ~A() { delete p; }
+};`,
+			want: []string{"missing-delete q:3"},
+		},
+		{
+			name: "array mismatch",
+			src: `class A { int *p; int *q;
+public:
+  A() { p = new int[4]; q = new int; }
+  ~A() { delete p; delete[] q; }
+};`,
+			want: []string{"array-mismatch p:4", "array-mismatch q:4"},
+		},
+		{
+			name: "reassignment",
+			src: `class A { int *p;
+public:
+  A() { p = new int; }
+  void reset() { p = new int; }
+  ~A() { delete p; }
+};`,
+			want: []string{"reassignment p:4"},
+		},
+		{
+			name: "reassignment after delete",
+			src: `class A { int *p;
+public:
+  A() { p = new int; }
+  void reset() {
+    delete p;
+    p = new int;
+  }
+  ~A() { delete p; }
+};`,
+		},
+		{
+			name: "double free through alias",
+			src: `class A { int *p;
+public:
+  A() { p = new int; }
+  void bad() { int *q = p; delete q; delete p; }
+  ~A() { delete p; }
+};`,
+			want: []string{"double-free p:4"},
+		},
+		{
+			name: "no destructor",
+			src: `class A { int *p;
+public:
+  A() { p = new int; }
+};`,
+			want: []string{"missing-delete p:3", "no-destructor p:1"},
+		},
+		{
+			name: "delete through a member alias",
+			src: `class A { int *p; int *q;
+public:
+  A() { p = new int; q = p; }
+  ~A() { delete q; }
+};`,
+		},
+		{
+			name: "delete through a chain in one function",
+			src: `class A { int *p; int *q;
+public:
+  A() { p = new int; }
+  ~A() { int *a = p; int *b = a; delete b; }
+};`,
+		},
+		{
+			name: "locals of different methods do not alias",
+			src: `class A { int *p; int *q;
+public:
+  A() { p = new int; q = new int; }
+  int first() { int *tmp = p; return *tmp; }
+  int second() { int *tmp = q; return *tmp; }
+  ~A() { delete p; }
+};`,
+			want: []string{"missing-delete q:3"},
+		},
+		{
+			name: "delete in a helper the destructor calls",
+			src: `class A { int *p;
+public:
+  A() { p = new int; }
+  void release() { delete p; }
+  ~A() { release(); }
+};`,
+		},
+	} {
+		t.Run(tc.name, func(t *testing.T) {
+			if got := analyzeSource(t, tc.src); !slices.Equal(got, tc.want) {
+				t.Errorf("findings %q, want %q", got, tc.want)
+			}
+		})
+	}
+}
+
+func TestSetRules(t *testing.T) {
+	a := NewAnalyzer()
+	if err := a.SetRules([]string{"missing-delete", "no-such-rule"}); err == nil {
+		t.Error("SetRules accepted an unknown rule")
+	}
+	if err := a.SetRules([]string{parser.RuleNoDestructor}); err != nil {
+		t.Fatal(err)
+	}
+	a.AddClasses(parser.ParseSource("/src/test.cpp", []byte(`class A { int *p;
+public:
+  A() { p = new int; }
+};`)))
+	leaks := a.Analyze()
+	if len(leaks) != 1 || leaks[0].Rule != parser.RuleNoDestructor {
+		t.Errorf("findings %+v, want only no-destructor", leaks)
+	}
+}
+
+// corpusClasses parses and merges a generated corpus
+func corpusClasses(tb testing.TB, classes int) []parser.Class {
+	tb.Helper()
+	dir := tb.TempDir()
+	opts := corpus.DefaultOptions()
+	opts.Classes = classes
+	if _, err := corpus.Generate(dir, opts); err != nil {
+		tb.Fatal(err)
+	}
+	registry := parser.NewClassRegistry()
+	err := filepath.WalkDir(dir, func(path string, d os.DirEntry, err error) error {
+		if err != nil || d.IsDir() {
+			return err
+		}
+		parsed, err := parser.ParseFile(path)
+		registry.AddClasses(parsed)
+		return err
+	})
+	if err != nil {
+		tb.Fatal(err)
+	}
+	return registry.MergeClasses()
+}
+
+func TestAnalyzeWorkers(t *testing.T) {
+	classes := corpusClasses(t, 300)
+	serial := NewAnalyzer()
+	serial.SetWorkers(1)
+	serial.AddClasses(classes)
+	want := serial.Analyze()
+	if len(want) == 0 {
+		t.Fatal("no findings in the corpus")
+	}
+
+	parallel := NewAnalyzer()
+	parallel.SetWorkers(8)
+	parallel.AddClasses(classes)
+	got := parallel.Analyze()
+	if fmt.Sprint(got) != fmt.Sprint(want) {
+		t.Error("parallel analysis found different findings, or in a different order")
+	}
+}
+
+func BenchmarkAnalyzeClasses(b *testing.B) {
+	classes := corpusClasses(b, 1000)
+	b.ReportAllocs()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		AnalyzeClasses(classes)
+	}
+}
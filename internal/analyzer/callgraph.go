@@ -0,0 +1,174 @@
+package analyzer
+
+import (
+	"leakcheck/internal/parser"
+	"sort"
+)
+
+// deallocSet maps a variable name to the deallocation that frees it.
+// Sets are shared between call graph nodes and must not be modified once built.
+type deallocSet map[string]parser.Deallocation
+
+// callGraph is the resolved method call graph of a single class.
+// Nodes 0..len(Methods)-1 are the class methods; the destructor, if any, is the last node.
+type callGraph struct {
+	funcs []*parser.Function
+	calls [][]int32
+
+	// Tarjan state; summary holds the memoized transitive deallocation set of each node
+	// and component the root of the strongly connected component it belongs to
+	index     []int32
+	low       []int32
+	onStack   []bool
+	stack     []int32
+	counter   int32
+	summary   []deallocSet
+	component []int32
+}
+
+// newCallGraph resolves every MethodCalls entry of the class once.
+// Like a by-name lookup, calls to an overloaded name resolve to the last definition.
+func newCallGraph(class *parser.Class) *callGraph {
+	n := len(class.Methods)
+	if class.Destructor != nil {
+		n++
+	}
+	g := &callGraph{
+		funcs: make([]*parser.Function, 0, n),
+		calls: make([][]int32, n),
+	}
+	byName := make(map[string]int32, len(class.Methods))
+	for i := range class.Methods {
+		g.funcs = append(g.funcs, &class.Methods[i])
+		byName[class.Methods[i].Name] = int32(i)
+	}
+	if class.Destructor != nil {
+		g.funcs = append(g.funcs, class.Destructor)
+	}
+
+	for i, fn := range g.funcs {
+		for _, name := range fn.MethodCalls {
+			if callee, ok := byName[name]; ok {
+				g.calls[i] = append(g.calls[i], callee)
+			}
+		}
+	}
+	return g
+}
+
+// destructorDeallocations returns everything the destructor frees directly or through
+// any chain of method calls, or nil if the class has no destructor
+func (g *callGraph) destructorDeallocations() deallocSet {
+	if len(g.funcs) == 0 || g.funcs[len(g.funcs)-1] == nil {
+		return nil
+	}
+	return g.deallocations(int32(len(g.funcs) - 1))
+}
+
+// deallocations returns the transitive deallocation set of node v, computing the
+// summaries of v and everything it reaches on first use
+func (g *callGraph) deallocations(v int32) deallocSet {
+	if g.index == nil {
+		n := len(g.funcs)
+		g.index = make([]int32, n)
+		g.low = make([]int32, n)
+		g.onStack = make([]bool, n)
+		g.summary = make([]deallocSet, n)
+		g.component = make([]int32, n)
+		for i := range g.index {
+			g.index[i] = -1
+		}
+	}
+	if g.index[v] < 0 {
+		g.connect(v)
+	}
+	return g.summary[v]
+}
+
+// connect is Tarjan's strongly connected components step. Methods that call each other
+// recursively form one component and share a single summary: the deallocations of all
+// members, followed by the summaries of the components they call. Later entries win when
+// a variable is freed in more than one place, as with a depth-first walk.
+func (g *callGraph) connect(v int32) {
+	g.index[v] = g.counter
+	g.low[v] = g.counter
+	g.counter++
+	g.stack = append(g.stack, v)
+	g.onStack[v] = true
+
+	for _, w := range g.calls[v] {
+		if g.index[w] < 0 {
+			g.connect(w)
+			g.low[v] = min(g.low[v], g.low[w])
+		} else if g.onStack[w] {
+			g.low[v] = min(g.low[v], g.index[w])
+		}
+	}
+
+	if g.low[v] != g.index[v] {
+		return
+	}
+
+	// Pop the component rooted at v
+	top := len(g.stack) - 1
+	for g.stack[top] != v {
+		top--
+	}
+	members := append([]int32(nil), g.stack[top:]...)
+	g.stack = g.stack[:top]
+	for _, m := range members {
+		g.onStack[m] = false
+	}
+	sort.Slice(members, func(i, j int) bool { return members[i] < members[j] })
+
+	for _, m := range members {
+		g.component[m] = v
+	}
+
+	// Gather the callee components outside this one; callees finish first in Tarjan's
+	// order, so their summaries are already final
+	var callees []int32
+	own := 0
+	for _, m := range members {
+		own += len(g.funcs[m].Deallocations)
+		for _, w := range g.calls[m] {
+			if c := g.component[w]; c != v && len(g.summary[w]) > 0 {
+				callees = append(callees, c)
+			}
+		}
+	}
+
+	var set deallocSet
+	switch {
+	case own == 0 && len(callees) == 0:
+		// Nothing is freed along any path
+	case own == 0 && allSame(callees):
+		// Only forwards to one component: share its set
+		set = g.summary[callees[0]]
+	default:
+		set = make(deallocSet, own)
+		for _, m := range members {
+			for _, dealloc := range g.funcs[m].Deallocations {
+				set[dealloc.VarName] = dealloc
+			}
+		}
+		for _, c := range callees {
+			for name, dealloc := range g.summary[c] {
+				set[name] = dealloc
+			}
+		}
+	}
+	for _, m := range members {
+		g.summary[m] = set
+	}
+}
+
+// allSame reports whether every entry of ids is the same
+func allSame(ids []int32) bool {
+	for _, id := range ids[1:] {
+		if id != ids[0] {
+			return false
+		}
+	}
+	return true
+}
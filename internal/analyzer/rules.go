@@ -0,0 +1,311 @@
+package analyzer
+
+import (
+	"fmt"
+	"slices"
+	"strings"
+
+	"leakcheck/internal/parser"
+)
+
+// rule is one leak check. Rules run in registration order on every class
+// with pointer members, appending their findings.
+type rule struct {
+	id    string
+	check func(ix *classIndex, leaks []parser.Leak) []parser.Leak
+}
+
+// rules lists every check, in the order their findings are reported
+var rules = []rule{
+	{parser.RuleMissingDelete, checkMissingDelete},
+	{parser.RuleArrayMismatch, checkArrayMismatch},
+	{parser.RuleReassignment, checkReassignment},
+	{parser.RuleDoubleFree, checkDoubleFree},
+	{parser.RuleNoDestructor, checkNoDestructor},
+}
+
+// RuleIDs returns the IDs of every rule, in the order they run
+func RuleIDs() []string {
+	ids := make([]string, len(rules))
+	for i, r := range rules {
+		ids[i] = r.id
+	}
+	return ids
+}
+
+// classIndex is what the rules need to know about one class, computed once
+// and shared by all of them. Parts only some rules need are built on first
+// use, so disabling those rules skips the work.
+type classIndex struct {
+	class          *parser.Class
+	qualifiedName  string // the class name findings report
+	pointerMembers map[string]parser.Member
+	// Constructor allocations by variable (the last one winning), and the
+	// variables in order of first allocation
+	allocated  map[string]parser.Allocation
+	allocOrder []string
+
+	freedReady bool
+	freed      deallocSet // destructor deallocations, following method calls
+	aliases    *aliasSets // with the freed variables marked
+
+	// Deallocations of each method sorted by variable, then line
+	methodFrees [][]parser.Deallocation
+}
+
+// newClassIndex indexes class, or returns nil if it has no pointer members
+// and so nothing to report
+func newClassIndex(class *parser.Class) *classIndex {
+	var pointerMembers map[string]parser.Member
+	for _, m := range class.Members {
+		if m.IsPointer {
+			if pointerMembers == nil {
+				pointerMembers = make(map[string]parser.Member)
+			}
+			pointerMembers[m.Name] = m
+		}
+	}
+	if pointerMembers == nil {
+		return nil
+	}
+
+	ix := &classIndex{
+		class:          class,
+		qualifiedName:  class.QualifiedName(),
+		pointerMembers: pointerMembers,
+		allocated:      make(map[string]parser.Allocation),
+	}
+	if class.Constructor != nil {
+		for _, alloc := range class.Constructor.Allocations {
+			if _, seen := ix.allocated[alloc.VarName]; !seen {
+				ix.allocOrder = append(ix.allocOrder, alloc.VarName)
+			}
+			ix.allocated[alloc.VarName] = alloc
+		}
+	}
+	return ix
+}
+
+// deallocation returns how the destructor frees the constructor-allocated
+// variable, directly or through an alias
+func (ix *classIndex) deallocation(varName string) (parser.Deallocation, bool) {
+	if !ix.freedReady {
+		if ix.class.Destructor != nil && len(ix.allocated) > 0 {
+			ix.freed = newCallGraph(ix.class).destructorDeallocations()
+		}
+		ix.aliases = buildAliasSets(ix.class) // Group variables that may point to the same memory
+		ix.aliases.markFreed(ix.freed)
+		ix.freedReady = true
+	}
+	return ix.aliases.deallocation(varName, ix.freed)
+}
+
+// sourceFile returns the file a finding at an item parsed from file is
+// in, falling back to the class's files for items built without one
+func (ix *classIndex) sourceFile(file string) string {
+	if file == "" {
+		return ix.class.File
+	}
+	return file
+}
+
+// firstFree returns the line of the first deallocation of varName in
+// method i, or 0 if the method does not free it
+func (ix *classIndex) firstFree(i int, varName string) int {
+	if ix.methodFrees == nil {
+		ix.methodFrees = make([][]parser.Deallocation, len(ix.class.Methods))
+	}
+	frees := ix.methodFrees[i]
+	if frees == nil {
+		frees = slices.Clone(ix.class.Methods[i].Deallocations)
+		if frees == nil {
+			frees = []parser.Deallocation{}
+		}
+		slices.SortFunc(frees, func(a, b parser.Deallocation) int {
+			if c := strings.Compare(a.VarName, b.VarName); c != 0 {
+				return c
+			}
+			return a.Line - b.Line
+		})
+		ix.methodFrees[i] = frees
+	}
+	j, found := slices.BinarySearchFunc(frees, varName, func(d parser.Deallocation, name string) int {
+		return strings.Compare(d.VarName, name)
+	})
+	if !found {
+		return 0
+	}
+	return frees[j].Line
+}
+
+// checkMissingDelete reports members allocated in the constructor but not
+// deleted in the destructor
+func checkMissingDelete(ix *classIndex, leaks []parser.Leak) []parser.Leak {
+	class := ix.class
+	for _, varName := range ix.allocOrder {
+		if _, deleted := ix.deallocation(varName); deleted {
+			continue
+		}
+		alloc := ix.allocated[varName]
+		deleteOp := "delete"
+		if alloc.IsArray {
+			deleteOp = "delete[]"
+		}
+		leaks = append(leaks, parser.Leak{
+			File:           class.File,
+			Files:          class.Files,
+			SourceFile:     ix.sourceFile(alloc.File),
+			Line:           alloc.Line,
+			ClassName:      ix.qualifiedName,
+			VarName:        varName,
+			Reason:         "allocated with 'new' but not deleted in destructor",
+			Severity:       "error",
+			Rule:           parser.RuleMissingDelete,
+			Recommendation: "In destructor ~" + class.Name + "(), add: " + deleteOp + " " + varName + "; // prevents memory leak from line " + fmt.Sprintf("%d", alloc.Line),
+		})
+	}
+	return leaks
+}
+
+// checkArrayMismatch reports constructor allocations freed with the wrong
+// form of delete
+func checkArrayMismatch(ix *classIndex, leaks []parser.Leak) []parser.Leak {
+	class := ix.class
+	for _, varName := range ix.allocOrder {
+		dealloc, deleted := ix.deallocation(varName)
+		if !deleted {
+			continue
+		}
+		if alloc := ix.allocated[varName]; alloc.IsArray && !dealloc.IsArray {
+			leaks = append(leaks, parser.Leak{
+				File:           class.File,
+				Files:          class.Files,
+				SourceFile:     ix.sourceFile(dealloc.File),
+				Line:           dealloc.Line,
+				ClassName:      ix.qualifiedName,
+				VarName:        varName,
+				Reason:         "allocated with 'new[]' but deleted with 'delete' instead of 'delete[]'",
+				Severity:       "error",
+				Rule:           parser.RuleArrayMismatch,
+				Recommendation: fmt.Sprintf("At line %d, change 'delete %s' to 'delete[] %s'. Using delete on array allocations causes undefined behavior.", dealloc.Line, varName, varName),
+			})
+		} else if !alloc.IsArray && dealloc.IsArray {
+			leaks = append(leaks, parser.Leak{
+				File:           class.File,
+				Files:          class.Files,
+				SourceFile:     ix.sourceFile(dealloc.File),
+				Line:           dealloc.Line,
+				ClassName:      ix.qualifiedName,
+				VarName:        varName,
+				Reason:         "allocated with 'new' but deleted with 'delete[]' instead of 'delete'",
+				Severity:       "warning",
+				Rule:           parser.RuleArrayMismatch,
+				Recommendation: fmt.Sprintf("At line %d, change 'delete[] %s' to 'delete %s'. Single object allocated with 'new' should use 'delete'.", dealloc.Line, varName, varName),
+			})
+		}
+	}
+	return leaks
+}
+
+// checkReassignment reports methods that allocate a constructor-allocated
+// member again without deleting it first
+func checkReassignment(ix *classIndex, leaks []parser.Leak) []parser.Leak {
+	class := ix.class
+	for i := range class.Methods {
+		method := &class.Methods[i]
+		for _, alloc := range method.Allocations {
+			if _, exists := ix.pointerMembers[alloc.VarName]; !exists {
+				continue
+			}
+			if _, wasAllocatedInCtor := ix.allocated[alloc.VarName]; !wasAllocatedInCtor {
+				continue
+			}
+			// Deallocated in the same method before the reassignment
+			if line := ix.firstFree(i, alloc.VarName); line != 0 && line < alloc.Line {
+				continue
+			}
+			leaks = append(leaks, parser.Leak{
+				File:           class.File,
+				Files:          class.Files,
+				SourceFile:     ix.sourceFile(alloc.File),
+				Line:           alloc.Line,
+				ClassName:      ix.qualifiedName,
+				VarName:        alloc.VarName,
+				Reason:         "pointer reassigned with 'new' without deleting previous allocation (in " + method.Name + ")",
+				Severity:       "warning",
+				Rule:           parser.RuleReassignment,
+				Recommendation: fmt.Sprintf("Before line %d in %s::%s(), add: delete %s; // Or consider using std::unique_ptr<%s> for automatic memory management", alloc.Line, ix.qualifiedName, method.Name, alloc.VarName, "T"),
+			})
+		}
+	}
+	return leaks
+}
+
+// checkDoubleFree reports methods that delete a pointer member and an
+// alias of it
+func checkDoubleFree(ix *classIndex, leaks []parser.Leak) []parser.Leak {
+	class := ix.class
+	for i := range class.Methods {
+		method := &class.Methods[i]
+		for _, alias := range method.Aliases {
+			if _, isPointerMember := ix.pointerMembers[alias.SourceVar]; !isPointerMember {
+				continue
+			}
+			if ix.firstFree(i, alias.SourceVar) == 0 || ix.firstFree(i, alias.TargetVar) == 0 {
+				continue
+			}
+			leaks = append(leaks, parser.Leak{
+				File:           class.File,
+				Files:          class.Files,
+				SourceFile:     ix.sourceFile(alias.File),
+				Line:           alias.Line,
+				ClassName:      ix.qualifiedName,
+				VarName:        alias.SourceVar,
+				Reason:         "pointer aliased to '" + alias.TargetVar + "' and both are deleted (potential double-free)",
+				Severity:       "error",
+				Rule:           parser.RuleDoubleFree,
+				Recommendation: fmt.Sprintf("Double-free detected: '%s' and '%s' point to same memory. Remove one delete, or set '%s = nullptr;' after first delete to prevent crash.", alias.SourceVar, alias.TargetVar, alias.SourceVar),
+			})
+		}
+	}
+	return leaks
+}
+
+// checkNoDestructor reports allocated members of a class without a
+// destructor, in declaration order
+func checkNoDestructor(ix *classIndex, leaks []parser.Leak) []parser.Leak {
+	class := ix.class
+	if class.Destructor != nil || len(ix.allocated) == 0 {
+		return leaks
+	}
+	seen := make(map[string]bool, len(ix.pointerMembers))
+	for _, member := range class.Members {
+		if !member.IsPointer || seen[member.Name] {
+			continue
+		}
+		seen[member.Name] = true
+		alloc, allocated := ix.allocated[member.Name]
+		if !allocated {
+			continue
+		}
+		// The last declaration of a name wins, as in the member index
+		member = ix.pointerMembers[member.Name]
+		deleteOp := "delete"
+		if alloc.IsArray {
+			deleteOp = "delete[]"
+		}
+		leaks = append(leaks, parser.Leak{
+			File:           class.File,
+			Files:          class.Files,
+			SourceFile:     ix.sourceFile(member.File),
+			Line:           member.Line,
+			ClassName:      ix.qualifiedName,
+			VarName:        member.Name,
+			Reason:         "pointer member allocated but class has no destructor",
+			Severity:       "error",
+			Rule:           parser.RuleNoDestructor,
+			Recommendation: fmt.Sprintf("Add destructor to class %s: ~%s() { %s %s; %s = nullptr; }", ix.qualifiedName, class.Name, deleteOp, member.Name, member.Name),
+		})
+	}
+	return leaks
+}
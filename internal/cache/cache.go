@@ -0,0 +1,117 @@
+package cache
+
+import (
+	"crypto/sha256"
+	"encoding/hex"
+	"os"
+	"path/filepath"
+
+	"leakcheck/internal/parser"
+)
+
+// schemaVersion is bumped whenever the on-disk entry layout changes
+const schemaVersion = "3"
+
+// Cache stores parsed classes on disk, keyed by file content hash. Each
+// entry is a class file (see parser.EncodeClasses).
+type Cache struct {
+	dir     string
+	version string
+}
+
+// New creates a cache rooted at dir. Entries written by a different
+// tool version are never returned.
+func New(dir, version string) (*Cache, error) {
+	if err := os.MkdirAll(dir, 0o755); err != nil {
+		return nil, err
+	}
+	return &Cache{dir: dir, version: version}, nil
+}
+
+// Key returns the cache key for a file's content
+func (c *Cache) Key(content []byte) string {
+	h := sha256.New()
+	h.Write([]byte(schemaVersion + "\x00" + c.version + "\x00"))
+	h.Write(content)
+	return hex.EncodeToString(h.Sum(nil))
+}
+
+// Load returns the cached classes for key, rewritten to belong to file.
+// The same content may live at several paths, so the stored file name
+// is never trusted. If keep is not nil, only the classes whose name it
+// accepts are decoded.
+func (c *Cache) Load(key, file string, keep func(name string) bool) ([]parser.Class, bool) {
+	data, release, err := parser.ReadSource(c.path(key))
+	if err != nil {
+		return nil, false
+	}
+	defer release()
+
+	// Decoded classes do not refer to data, so it can be released
+	classes, err := decodeClasses(data, keep)
+	if err != nil {
+		return nil, false
+	}
+	for i := range classes {
+		classes[i].SetFile(file)
+	}
+	return classes, true
+}
+
+// decodeClasses decodes the classes of a class file that keep accepts,
+// or all of them if keep is nil
+func decodeClasses(data []byte, keep func(name string) bool) ([]parser.Class, error) {
+	if keep == nil {
+		return parser.DecodeClasses(data)
+	}
+	f, err := parser.OpenClassFile(data)
+	if err != nil {
+		return nil, err
+	}
+	var classes []parser.Class
+	for i := 0; i < f.Len(); i++ {
+		if !keep(f.Name(i)) {
+			continue
+		}
+		class, err := f.Class(i)
+		if err != nil {
+			return nil, err
+		}
+		classes = append(classes, class)
+	}
+	return classes, nil
+}
+
+// Store writes classes under key
+func (c *Cache) Store(key string, classes []parser.Class) error {
+	data := parser.EncodeClasses(classes)
+	path := c.path(key)
+	if err := os.MkdirAll(filepath.Dir(path), 0o755); err != nil {
+		return err
+	}
+	return writeFileAtomic(path, data)
+}
+
+// writeFileAtomic writes data to a temporary file and renames it into
+// place, so concurrent runs never see a partially written file
+func writeFileAtomic(path string, data []byte) error {
+	tmp, err := os.CreateTemp(filepath.Dir(path), ".tmp-*")
+	if err != nil {
+		return err
+	}
+	if _, err := tmp.Write(data); err != nil {
+		tmp.Close()
+		os.Remove(tmp.Name())
+		return err
+	}
+	if err := tmp.Close(); err != nil {
+		os.Remove(tmp.Name())
+		return err
+	}
+	return os.Rename(tmp.Name(), path)
+}
+
+// path shards entries into subdirectories by key prefix
+func (c *Cache) path(key string) string {
+	return filepath.Join(c.dir, key[:2], key[2:]+".lkc")
+}
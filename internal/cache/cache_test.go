@@ -0,0 +1,119 @@
+package cache
+
+import (
+	"os"
+	"path/filepath"
+	"slices"
+	"testing"
+
+	"leakcheck/internal/parser"
+)
+
+const source = `namespace ns {
+class Foo { int *p;
+public:
+  Foo() { p = new int; }
+};
+class Bar { char *name; };
+}
+`
+
+func TestStoreLoad(t *testing.T) {
+	c, err := New(t.TempDir(), "1.0")
+	if err != nil {
+		t.Fatal(err)
+	}
+	content := []byte(source)
+	key := c.Key(content)
+	if _, ok := c.Load(key, "/b/foo.cpp", nil); ok {
+		t.Fatal("Load hit an empty cache")
+	}
+	if err := c.Store(key, parser.ParseSource("/a/foo.cpp", content)); err != nil {
+		t.Fatal(err)
+	}
+
+	// The same content at another path
+	classes, ok := c.Load(key, "/b/foo.cpp", nil)
+	if !ok || len(classes) != 2 {
+		t.Fatalf("Load = %d classes, %v; want 2, true", len(classes), ok)
+	}
+	foo := &classes[0]
+	if foo.QualifiedName() != "ns::Foo" || foo.File != "/b/foo.cpp" || foo.Constructor.Allocations[0].File != "/b/foo.cpp" {
+		t.Errorf("loaded %s from %s (allocation in %s), want ns::Foo from /b/foo.cpp",
+			foo.QualifiedName(), foo.File, foo.Constructor.Allocations[0].File)
+	}
+
+	kept, ok := c.Load(key, "/b/foo.cpp", func(name string) bool { return name == "Bar" })
+	if !ok || len(kept) != 1 || kept[0].Name != "Bar" {
+		t.Errorf("Load with a filter = %+v, want only Bar", kept)
+	}
+}
+
+func TestKeyVersions(t *testing.T) {
+	dir := t.TempDir()
+	old, _ := New(dir, "1.0")
+	current, _ := New(dir, "1.1")
+	content := []byte(source)
+	if old.Key(content) == current.Key(content) {
+		t.Error("two tool versions share a cache key")
+	}
+	if old.Key(content) == old.Key([]byte(source+"\n")) {
+		t.Error("different contents share a cache key")
+	}
+}
+
+func TestLoadCorrupt(t *testing.T) {
+	dir := t.TempDir()
+	c, _ := New(dir, "1.0")
+	content := []byte(source)
+	key := c.Key(content)
+	if err := c.Store(key, parser.ParseSource("/a/foo.cpp", content)); err != nil {
+		t.Fatal(err)
+	}
+	if err := os.WriteFile(c.path(key), []byte("LKCL\x02garbage"), 0o644); err != nil {
+		t.Fatal(err)
+	}
+	if _, ok := c.Load(key, "/a/foo.cpp", nil); ok {
+		t.Error("Load returned a corrupt entry")
+	}
+}
+
+func TestIndex(t *testing.T) {
+	dir := t.TempDir()
+	c, _ := New(dir, "1.0")
+	ix := c.LoadIndex()
+	if ix.Len() != 0 {
+		t.Fatalf("new index has %d files", ix.Len())
+	}
+	ix.Set("/a/foo.cpp", parser.ParseSource("/a/foo.cpp", []byte(source)))
+	ix.Set("/a/foo.h", []parser.Class{{Name: "Foo"}})
+	ix.Set("/a/other.h", []parser.Class{{Name: "Foo", Namespace: "other"}, {Name: "Baz"}})
+	ix.Set("/a/baz.h", []parser.Class{{Name: "Baz"}})
+	if err := ix.Save(); err != nil {
+		t.Fatal(err)
+	}
+
+	loaded := c.LoadIndex()
+	if got := loaded.Classes("/a/foo.cpp"); !slices.Equal(got, []string{"ns::Foo", "ns::Bar"}) {
+		t.Errorf("Classes(foo.cpp) = %q, want [ns::Foo ns::Bar]", got)
+	}
+	// Every class named Foo, in any namespace
+	got := loaded.FilesDefining(map[string]bool{"ns::Foo": true})
+	if want := []string{"/a/foo.cpp", "/a/foo.h", "/a/other.h"}; !slices.Equal(got, want) {
+		t.Errorf("FilesDefining(ns::Foo) = %q, want %q", got, want)
+	}
+
+	loaded.Remove("/a/baz.h")
+	if got := loaded.FilesDefining(map[string]bool{"Baz": true}); !slices.Equal(got, []string{"/a/other.h"}) {
+		t.Errorf("FilesDefining(Baz) after Remove = %q, want [/a/other.h]", got)
+	}
+
+	// An index written by another tool version is not used
+	other, _ := New(dir, "2.0")
+	if other.LoadIndex().Len() != 0 {
+		t.Error("index of another version was loaded")
+	}
+	if _, err := os.Stat(filepath.Join(dir, indexFile)); err != nil {
+		t.Error(err)
+	}
+}
@@ -0,0 +1,107 @@
+package cache
+
+import (
+	"encoding/json"
+	"os"
+	"path/filepath"
+	"sort"
+
+	"leakcheck/internal/parser"
+)
+
+// indexFile is the name of the class index inside the cache directory
+const indexFile = "index.json"
+
+// Index records which classes each file defines. Classes can be split
+// across a header and an implementation, so a change to one file is
+// traced through the index to every other file defining the same class.
+type Index struct {
+	path    string
+	Version string              `json:"version"`
+	Files   map[string][]string `json:"files"` // file -> qualified class names
+}
+
+// LoadIndex reads the class index from the cache directory. A missing,
+// unreadable or outdated index is returned as an empty index.
+func (c *Cache) LoadIndex() *Index {
+	ix := c.NewIndex()
+	data, err := os.ReadFile(ix.path)
+	if err != nil {
+		return ix
+	}
+
+	var stored Index
+	if err := json.Unmarshal(data, &stored); err != nil || stored.Version != ix.Version || stored.Files == nil {
+		return ix
+	}
+	ix.Files = stored.Files
+	return ix
+}
+
+// NewIndex returns an empty class index that saves to the cache directory
+func (c *Cache) NewIndex() *Index {
+	return &Index{
+		path:    filepath.Join(c.dir, indexFile),
+		Version: schemaVersion + "/" + c.version,
+		Files:   make(map[string][]string),
+	}
+}
+
+// Len returns the number of indexed files
+func (ix *Index) Len() int {
+	return len(ix.Files)
+}
+
+// Set records the classes parsed from file, replacing earlier entries
+func (ix *Index) Set(file string, classes []parser.Class) {
+	names := make([]string, 0, len(classes))
+	seen := make(map[string]bool, len(classes))
+	for i := range classes {
+		if name := classes[i].QualifiedName(); !seen[name] {
+			seen[name] = true
+			names = append(names, name)
+		}
+	}
+	ix.Files[file] = names
+}
+
+// Remove drops file from the index
+func (ix *Index) Remove(file string) {
+	delete(ix.Files, file)
+}
+
+// Classes returns the qualified names of the classes defined in file
+func (ix *Index) Classes(file string) []string {
+	return ix.Files[file]
+}
+
+// FilesDefining returns the sorted list of files that define a class named
+// like any of names (qualified), in any namespace. A definition after
+// "using namespace" does not name its namespace, and the registry can only
+// pick the class it belongs to when it sees every class of that name.
+func (ix *Index) FilesDefining(names map[string]bool) []string {
+	bases := make(map[string]bool, len(names))
+	for name := range names {
+		bases[parser.BaseName(name)] = true
+	}
+	var files []string
+	for file, classes := range ix.Files {
+		for _, name := range classes {
+			if bases[parser.BaseName(name)] {
+				files = append(files, file)
+				break
+			}
+		}
+	}
+	sort.Strings(files)
+	return files
+}
+
+// Save writes the index back to the cache directory
+func (ix *Index) Save() error {
+	data, err := json.Marshal(ix)
+	if err != nil {
+		return err
+	}
+	return writeFileAtomic(ix.path, data)
+}
@@ -0,0 +1,230 @@
+package corpus
+
+import (
+	"fmt"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"strings"
+)
+
+// Options controls the shape of a generated corpus
+type Options struct {
+	Classes        int     // Number of classes, each split into a .h/.cpp pair
+	ClassesPerDir  int     // Classes per subdirectory
+	Members        int     // Pointer members per class
+	CallDepth      int     // Length of the destructor's cleanup call chain
+	Aliases        int     // Alias assignments per alias-heavy method
+	FreeFunctions  int     // Free functions without new/delete per .cpp file
+	LeakRate       float64 // Fraction of classes that forget one delete
+	Seed           int64   // Seed for the pseudo-random choices
+	NamespaceDepth int     // Nested namespaces wrapping each class
+}
+
+// DefaultOptions returns options for a medium-sized corpus
+func DefaultOptions() Options {
+	return Options{
+		Classes:        2000,
+		ClassesPerDir:  100,
+		Members:        6,
+		CallDepth:      4,
+		Aliases:        6,
+		FreeFunctions:  4,
+		LeakRate:       0.1,
+		Seed:           1,
+		NamespaceDepth: 2,
+	}
+}
+
+// Stats describes a generated corpus
+type Stats struct {
+	Files   int
+	Bytes   int64
+	Classes int
+	Leaks   int // Classes generated with a deliberate missing delete
+}
+
+// Generate writes a synthetic C++ corpus under dir. The output is fully
+// determined by opts, so runs with the same options are comparable.
+func Generate(dir string, opts Options) (Stats, error) {
+	var stats Stats
+	if opts.ClassesPerDir < 1 {
+		opts.ClassesPerDir = 1
+	}
+	if opts.Members < 1 {
+		opts.Members = 1
+	}
+	rng := rand.New(rand.NewSource(opts.Seed))
+
+	for i := 0; i < opts.Classes; i++ {
+		sub := filepath.Join(dir, fmt.Sprintf("module%03d", i/opts.ClassesPerDir))
+		if err := os.MkdirAll(sub, 0o755); err != nil {
+			return stats, err
+		}
+
+		g := classGen{
+			opts: opts,
+			name: fmt.Sprintf("Widget%05d", i),
+			leak: rng.Float64() < opts.LeakRate,
+			rng:  rng,
+		}
+		header, impl := g.header(), g.impl()
+
+		base := filepath.Join(sub, strings.ToLower(g.name))
+		for _, f := range []struct {
+			path string
+			data string
+		}{{base + ".h", header}, {base + ".cpp", impl}} {
+			if err := os.WriteFile(f.path, []byte(f.data), 0o644); err != nil {
+				return stats, err
+			}
+			stats.Files++
+			stats.Bytes += int64(len(f.data))
+		}
+
+		stats.Classes++
+		if g.leak {
+			stats.Leaks++
+		}
+	}
+
+	return stats, nil
+}
+
+// classGen produces the header and implementation of one class
+type classGen struct {
+	opts Options
+	name string
+	leak bool
+	rng  *rand.Rand
+}
+
+var memberTypes = []string{"int", "char", "double", "Buffer", "Node", "std::string"}
+
+func (g *classGen) member(i int) string {
+	return fmt.Sprintf("m_field%d", i)
+}
+
+// isArray reports whether member i is allocated with new[]
+func (g *classGen) isArray(i int) bool {
+	return i%3 == 1
+}
+
+func (g *classGen) openNamespaces(sb *strings.Builder) {
+	for d := 0; d < g.opts.NamespaceDepth; d++ {
+		fmt.Fprintf(sb, "namespace level%d {\n", d)
+	}
+}
+
+func (g *classGen) closeNamespaces(sb *strings.Builder) {
+	for d := g.opts.NamespaceDepth - 1; d >= 0; d-- {
+		fmt.Fprintf(sb, "} // namespace level%d\n", d)
+	}
+}
+
+func (g *classGen) header() string {
+	var sb strings.Builder
+	guard := strings.ToUpper(g.name) + "_H"
+	fmt.Fprintf(&sb, "// Generated by leakbench. Do not edit.\n#ifndef %s\n#define %s\n\n#include <string>\n\n", guard, guard)
+	g.openNamespaces(&sb)
+
+	fmt.Fprintf(&sb, "\n/*\n * %s owns %d heap buffers and releases them\n * through a chain of %d cleanup methods.\n */\n", g.name, g.opts.Members, g.opts.CallDepth)
+	fmt.Fprintf(&sb, "class %s {\npublic:\n", g.name)
+	fmt.Fprintf(&sb, "    %s(int size);\n    ~%s();\n\n", g.name, g.name)
+	fmt.Fprintf(&sb, "    int size() const { return m_size; }\n    bool empty() const { return m_size == 0; }\n")
+	fmt.Fprintf(&sb, "    void swapBuffers();\n    void reset(int size);\n\n")
+	sb.WriteString("private:\n")
+	for d := 0; d < g.opts.CallDepth; d++ {
+		fmt.Fprintf(&sb, "    void cleanup%d();\n", d)
+	}
+	sb.WriteString("\n")
+	for i := 0; i < g.opts.Members; i++ {
+		fmt.Fprintf(&sb, "    %s* %s;\n", memberTypes[i%len(memberTypes)], g.member(i))
+	}
+	sb.WriteString("    int m_size;\n};\n\n")
+
+	g.closeNamespaces(&sb)
+	fmt.Fprintf(&sb, "\n#endif // %s\n", guard)
+	return sb.String()
+}
+
+func (g *classGen) impl() string {
+	var sb strings.Builder
+	fmt.Fprintf(&sb, "// Generated by leakbench. Do not edit.\n#include \"%s.h\"\n#include <cstring>\n\n", strings.ToLower(g.name))
+	g.openNamespaces(&sb)
+	sb.WriteString("\n")
+
+	// Free functions the parser can skip
+	for f := 0; f < g.opts.FreeFunctions; f++ {
+		fmt.Fprintf(&sb, "static int helper%d_%s(int a, int b) {\n", f, g.name)
+		fmt.Fprintf(&sb, "    int total = 0;\n    for (int i = 0; i < a; ++i) {\n        if (i %% %d == 0) { total += b; } else { total -= i; }\n    }\n    return total; // \"{ not a brace }\"\n}\n\n", f+2)
+	}
+
+	// Constructor: allocate every member
+	fmt.Fprintf(&sb, "%s::%s(int size) : m_size(size) {\n", g.name, g.name)
+	for i := 0; i < g.opts.Members; i++ {
+		typ := memberTypes[i%len(memberTypes)]
+		if g.isArray(i) {
+			fmt.Fprintf(&sb, "    %s = new %s[size];\n", g.member(i), typ)
+		} else {
+			fmt.Fprintf(&sb, "    %s = new %s();\n", g.member(i), typ)
+		}
+	}
+	sb.WriteString("}\n\n")
+
+	// Destructor starts the cleanup chain
+	fmt.Fprintf(&sb, "%s::~%s() {\n", g.name, g.name)
+	if g.opts.CallDepth > 0 {
+		sb.WriteString("    cleanup0();\n")
+	} else {
+		g.writeDeletes(&sb)
+	}
+	sb.WriteString("}\n\n")
+
+	// Each cleanup step calls the next; the last one deletes the members
+	for d := 0; d < g.opts.CallDepth; d++ {
+		fmt.Fprintf(&sb, "void %s::cleanup%d() {\n", g.name, d)
+		if d+1 < g.opts.CallDepth {
+			fmt.Fprintf(&sb, "    cleanup%d();\n", d+1)
+		} else {
+			g.writeDeletes(&sb)
+		}
+		sb.WriteString("}\n\n")
+	}
+
+	// Alias-heavy method: a chain of plain pointer copies
+	fmt.Fprintf(&sb, "void %s::swapBuffers() {\n", g.name)
+	prev := g.member(0)
+	for a := 0; a < g.opts.Aliases; a++ {
+		alias := fmt.Sprintf("tmp%d", a)
+		fmt.Fprintf(&sb, "    %s* %s;\n    %s = %s;\n", memberTypes[0], alias, alias, prev)
+		prev = alias
+	}
+	sb.WriteString("}\n\n")
+
+	// Reassignment with a proper delete first
+	pick := g.rng.Intn(g.opts.Members)
+	fmt.Fprintf(&sb, "void %s::reset(int size) {\n", g.name)
+	if g.isArray(pick) {
+		fmt.Fprintf(&sb, "    delete[] %s;\n    %s = new %s[size];\n", g.member(pick), g.member(pick), memberTypes[pick%len(memberTypes)])
+	} else {
+		fmt.Fprintf(&sb, "    delete %s;\n    %s = new %s();\n", g.member(pick), g.member(pick), memberTypes[pick%len(memberTypes)])
+	}
+	sb.WriteString("    m_size = size;\n}\n\n")
+
+	g.closeNamespaces(&sb)
+	return sb.String()
+}
+
+func (g *classGen) writeDeletes(sb *strings.Builder) {
+	for i := 0; i < g.opts.Members; i++ {
+		if g.leak && i == g.opts.Members-1 {
+			continue // Deliberate leak
+		}
+		if g.isArray(i) {
+			fmt.Fprintf(sb, "    delete[] %s;\n", g.member(i))
+		} else {
+			fmt.Fprintf(sb, "    delete %s;\n", g.member(i))
+		}
+	}
+}
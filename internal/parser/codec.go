@@ -0,0 +1,435 @@
+package parser
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"slices"
+)
+
+// Class files store parsed classes for the parse cache and shard dumps.
+// The layout is:
+//
+//	magic "LKCL", format version     (uvarint)
+//	string count, then per string:   length, bytes
+//	class count, then per class:     name (string index), body length
+//	class bodies, back to back
+//
+// Counts, lengths and string indexes are uvarints and line numbers are
+// varints. Names are stored once in the string table however often they
+// occur. The class index lets OpenClassFile list the classes by name and
+// decode any one of them without touching the other bodies.
+const (
+	classFileMagic = "LKCL"
+	// ClassFileVersion is bumped whenever the layout changes
+	ClassFileVersion = 2
+)
+
+// errCorrupt is returned for truncated or inconsistent class files
+var errCorrupt = errors.New("corrupt class file")
+
+// EncodeClasses encodes classes as a class file
+func EncodeClasses(classes []Class) []byte {
+	e := classEncoder{ids: make(map[string]uint64)}
+	bodies := make([][]byte, len(classes))
+	var body []byte
+	for i := range classes {
+		start := len(body)
+		body = e.class(body, &classes[i])
+		bodies[i] = body[start:]
+	}
+
+	out := make([]byte, 0, len(classFileMagic)+len(body)+16*len(e.strings)+8*len(classes))
+	out = append(out, classFileMagic...)
+	out = binary.AppendUvarint(out, ClassFileVersion)
+	out = binary.AppendUvarint(out, uint64(len(e.strings)))
+	for _, s := range e.strings {
+		out = binary.AppendUvarint(out, uint64(len(s)))
+		out = append(out, s...)
+	}
+	out = binary.AppendUvarint(out, uint64(len(classes)))
+	for i := range classes {
+		out = binary.AppendUvarint(out, e.ids[classes[i].Name])
+		out = binary.AppendUvarint(out, uint64(len(bodies[i])))
+	}
+	return append(out, body...)
+}
+
+// classEncoder builds the string table while class bodies are encoded
+type classEncoder struct {
+	ids     map[string]uint64
+	strings []string
+}
+
+// id returns the string table index of s, adding it if needed
+func (e *classEncoder) id(s string) uint64 {
+	id, ok := e.ids[s]
+	if !ok {
+		id = uint64(len(e.strings))
+		e.ids[s] = id
+		e.strings = append(e.strings, s)
+	}
+	return id
+}
+
+func (e *classEncoder) str(b []byte, s string) []byte {
+	return binary.AppendUvarint(b, e.id(s))
+}
+
+func (e *classEncoder) class(b []byte, c *Class) []byte {
+	e.id(c.Name) // the name is stored in the index
+	b = e.str(b, c.Namespace)
+	b = e.str(b, c.File)
+	b = binary.AppendUvarint(b, uint64(len(c.Includes)))
+	for _, include := range c.Includes {
+		b = e.str(b, include)
+	}
+	b = binary.AppendVarint(b, int64(c.StartLine))
+	b = binary.AppendVarint(b, int64(c.EndLine))
+	b = binary.AppendUvarint(b, uint64(len(c.Members)))
+	for i := range c.Members {
+		m := &c.Members[i]
+		b = e.str(b, m.Name)
+		b = e.str(b, m.Type)
+		b = append(b, flags(m.IsPointer, m.IsArray))
+		b = binary.AppendVarint(b, int64(m.Line))
+	}
+	b = e.optionalFunction(b, c.Constructor)
+	b = e.optionalFunction(b, c.Destructor)
+	b = binary.AppendUvarint(b, uint64(len(c.Methods)))
+	for i := range c.Methods {
+		b = e.function(b, &c.Methods[i])
+	}
+	return b
+}
+
+func (e *classEncoder) optionalFunction(b []byte, fn *Function) []byte {
+	if fn == nil {
+		return append(b, 0)
+	}
+	return e.function(append(b, 1), fn)
+}
+
+func (e *classEncoder) function(b []byte, fn *Function) []byte {
+	b = e.str(b, fn.Name)
+	b = append(b, flags(fn.IsDestructor, false))
+	b = binary.AppendVarint(b, int64(fn.StartLine))
+	b = binary.AppendVarint(b, int64(fn.EndLine))
+	b = binary.AppendUvarint(b, uint64(len(fn.Allocations)))
+	for _, a := range fn.Allocations {
+		b = e.str(b, a.VarName)
+		b = append(b, flags(a.IsArray, false))
+		b = binary.AppendVarint(b, int64(a.Line))
+	}
+	b = binary.AppendUvarint(b, uint64(len(fn.Deallocations)))
+	for _, d := range fn.Deallocations {
+		b = e.str(b, d.VarName)
+		b = append(b, flags(d.IsArray, false))
+		b = binary.AppendVarint(b, int64(d.Line))
+	}
+	b = binary.AppendUvarint(b, uint64(len(fn.MethodCalls)))
+	for _, call := range fn.MethodCalls {
+		b = e.str(b, call)
+	}
+	b = binary.AppendUvarint(b, uint64(len(fn.Aliases)))
+	for _, a := range fn.Aliases {
+		b = e.str(b, a.SourceVar)
+		b = e.str(b, a.TargetVar)
+		b = binary.AppendVarint(b, int64(a.Line))
+	}
+	return b
+}
+
+func flags(first, second bool) byte {
+	var f byte
+	if first {
+		f |= 1
+	}
+	if second {
+		f |= 2
+	}
+	return f
+}
+
+// ClassFile is an opened class file. Classes are decoded on demand, and
+// never refer to the file's bytes: their strings come from Symbols, so a
+// memory-mapped file can be released once the classes needed are decoded.
+type ClassFile struct {
+	data    []byte
+	strings []string
+	names   []string
+	bodies  []int // offset of each body in data, plus the end offset
+}
+
+// OpenClassFile reads the header, string table and class index of data
+func OpenClassFile(data []byte) (*ClassFile, error) {
+	if len(data) < len(classFileMagic) || string(data[:len(classFileMagic)]) != classFileMagic {
+		return nil, errors.New("not a class file")
+	}
+	d := decoder{data: data, pos: len(classFileMagic)}
+	if version := d.uvarint(); d.err == nil && version != ClassFileVersion {
+		return nil, fmt.Errorf("unsupported class file version %d", version)
+	}
+
+	f := &ClassFile{data: data}
+	n := d.count()
+	f.strings = make([]string, n)
+	for i := range f.strings {
+		length := d.count()
+		if d.err != nil || length > len(data)-d.pos {
+			return nil, errCorrupt
+		}
+		f.strings[i] = Symbols.InternBytes(data[d.pos : d.pos+length])
+		d.pos += length
+	}
+	d.strings = f.strings
+
+	n = d.count()
+	f.names = make([]string, n)
+	f.bodies = make([]int, n+1)
+	offset := 0
+	for i := range f.names {
+		f.names[i] = d.str()
+		f.bodies[i] = offset
+		offset += d.count()
+	}
+	if d.err != nil || offset != len(data)-d.pos {
+		return nil, errCorrupt
+	}
+	for i := range f.bodies {
+		f.bodies[i] += d.pos
+	}
+	f.bodies[n] = len(data)
+	return f, nil
+}
+
+// Len returns the number of classes in the file
+func (f *ClassFile) Len() int {
+	return len(f.names)
+}
+
+// Name returns the name of class i without decoding it
+func (f *ClassFile) Name(i int) string {
+	return f.names[i]
+}
+
+// Class decodes class i
+func (f *ClassFile) Class(i int) (Class, error) {
+	d := decoder{strings: f.strings}
+	return f.decode(&d, i)
+}
+
+// decode decodes class i with d, so the classes of one file can share slabs
+func (f *ClassFile) decode(d *decoder, i int) (Class, error) {
+	d.data, d.pos = f.data[:f.bodies[i+1]], f.bodies[i]
+	c := d.class()
+	c.Name = f.names[i]
+	if d.err == nil && d.pos != len(d.data) {
+		d.err = errCorrupt
+	}
+	return c, d.err
+}
+
+// DecodeClasses decodes every class of a class file
+func DecodeClasses(data []byte) ([]Class, error) {
+	f, err := OpenClassFile(data)
+	if err != nil {
+		return nil, err
+	}
+	classes := make([]Class, f.Len())
+	d := decoder{strings: f.strings}
+	for i := range classes {
+		if classes[i], err = f.decode(&d, i); err != nil {
+			return nil, err
+		}
+	}
+	return classes, nil
+}
+
+// decoder reads class file fields. The first error sticks: later reads
+// return zero values, so callers check err once at the end.
+type decoder struct {
+	data    []byte
+	pos     int
+	strings []string
+	err     error
+
+	// Slabs the decoded slices are carved from, so decoding a file takes a
+	// few large allocations instead of several per function
+	members       []Member
+	functions     []Function
+	allocations   []Allocation
+	deallocations []Deallocation
+	names         []string
+	aliases       []PointerAlias
+
+	// The classes of one file list the same includes; consecutive classes
+	// share the decoded slice
+	lastIncludes []string
+	scratch      []string
+}
+
+// slabSize is the minimum number of elements allocated per slab
+const slabSize = 256
+
+// carve returns n elements from the slab, refilling it when it runs out.
+// The result's capacity is n, so appending to it never writes into the slab.
+func carve[T any](slab *[]T, n int) []T {
+	if n > len(*slab) {
+		*slab = make([]T, max(n, slabSize))
+	}
+	s := (*slab)[:n:n]
+	*slab = (*slab)[n:]
+	return s
+}
+
+func (d *decoder) uvarint() uint64 {
+	if d.err != nil {
+		return 0
+	}
+	v, n := binary.Uvarint(d.data[d.pos:])
+	if n <= 0 {
+		d.err = errCorrupt
+		return 0
+	}
+	d.pos += n
+	return v
+}
+
+func (d *decoder) varint() int {
+	if d.err != nil {
+		return 0
+	}
+	v, n := binary.Varint(d.data[d.pos:])
+	if n <= 0 {
+		d.err = errCorrupt
+		return 0
+	}
+	d.pos += n
+	return int(v)
+}
+
+// count reads a length or element count. Every element takes at least one
+// byte, so a count larger than the rest of the data is corrupt; this keeps
+// a damaged file from causing a huge allocation.
+func (d *decoder) count() int {
+	v := d.uvarint()
+	if v > uint64(len(d.data)-d.pos) {
+		d.err = errCorrupt
+		return 0
+	}
+	return int(v)
+}
+
+func (d *decoder) flags() (bool, bool) {
+	if d.err != nil || d.pos >= len(d.data) {
+		d.err = errCorrupt
+		return false, false
+	}
+	f := d.data[d.pos]
+	d.pos++
+	return f&1 != 0, f&2 != 0
+}
+
+func (d *decoder) str() string {
+	id := d.uvarint()
+	if id >= uint64(len(d.strings)) {
+		d.err = errCorrupt
+		return ""
+	}
+	return d.strings[id]
+}
+
+func (d *decoder) class() Class {
+	c := Class{
+		Namespace: d.str(),
+		File:      d.str(),
+	}
+	c.Includes = d.includes()
+	c.StartLine = d.varint()
+	c.EndLine = d.varint()
+	if n := d.count(); n > 0 {
+		c.Members = carve(&d.members, n)
+		for i := range c.Members {
+			m := &c.Members[i]
+			m.Name = d.str()
+			m.Type = d.str()
+			m.IsPointer, m.IsArray = d.flags()
+			m.Line = d.varint()
+		}
+	}
+	c.Constructor = d.optionalFunction()
+	c.Destructor = d.optionalFunction()
+	if n := d.count(); n > 0 {
+		c.Methods = carve(&d.functions, n)
+		for i := range c.Methods {
+			d.function(&c.Methods[i])
+		}
+	}
+	c.SetFile(c.File)
+	return c
+}
+
+func (d *decoder) includes() []string {
+	n := d.count()
+	if n == 0 {
+		return nil
+	}
+	d.scratch = d.scratch[:0]
+	for i := 0; i < n; i++ {
+		d.scratch = append(d.scratch, d.str())
+	}
+	if !slices.Equal(d.scratch, d.lastIncludes) {
+		d.lastIncludes = append(carve(&d.names, n)[:0], d.scratch...)
+	}
+	return d.lastIncludes
+}
+
+func (d *decoder) optionalFunction() *Function {
+	if present, _ := d.flags(); !present {
+		return nil
+	}
+	fn := &carve(&d.functions, 1)[0]
+	d.function(fn)
+	return fn
+}
+
+func (d *decoder) function(fn *Function) {
+	fn.Name = d.str()
+	fn.IsDestructor, _ = d.flags()
+	fn.StartLine = d.varint()
+	fn.EndLine = d.varint()
+	if n := d.count(); n > 0 {
+		fn.Allocations = carve(&d.allocations, n)
+		for i := range fn.Allocations {
+			a := &fn.Allocations[i]
+			a.VarName = d.str()
+			a.IsArray, _ = d.flags()
+			a.Line = d.varint()
+		}
+	}
+	if n := d.count(); n > 0 {
+		fn.Deallocations = carve(&d.deallocations, n)
+		for i := range fn.Deallocations {
+			a := &fn.Deallocations[i]
+			a.VarName = d.str()
+			a.IsArray, _ = d.flags()
+			a.Line = d.varint()
+		}
+	}
+	if n := d.count(); n > 0 {
+		fn.MethodCalls = carve(&d.names, n)
+		for i := range fn.MethodCalls {
+			fn.MethodCalls[i] = d.str()
+		}
+	}
+	if n := d.count(); n > 0 {
+		fn.Aliases = carve(&d.aliases, n)
+		for i := range fn.Aliases {
+			a := &fn.Aliases[i]
+			a.SourceVar = d.str()
+			a.TargetVar = d.str()
+			a.Line = d.varint()
+		}
+	}
+}
@@ -0,0 +1,108 @@
+package parser
+
+import (
+	"fmt"
+	"testing"
+)
+
+const widgetSource = `class Widget {
+  Node *head;
+  char *label;
+
+public:
+  Widget();
+  ~Widget();
+};
+
+Widget::Widget() { head = new Node(); label = new char[16]; }
+Widget::~Widget() { cleanup(); delete head; }
+`
+
+func codecClasses() []Class {
+	classes := ParseSource("/src/buffer.cpp", []byte(bufferSource))
+	return append(classes, ParseSource("/src/widget.cpp", []byte(widgetSource))...)
+}
+
+// describe formats a class with its functions, printing nil and empty
+// slices alike: decoding does not keep the difference
+func describe(c Class) string {
+	function := func(fn *Function) string {
+		if fn == nil {
+			return "nil"
+		}
+		return fmt.Sprintf("%+v", *fn)
+	}
+	ctor, dtor := function(c.Constructor), function(c.Destructor)
+	c.Constructor, c.Destructor = nil, nil
+	return fmt.Sprintf("%+v constructor=%s destructor=%s", c, ctor, dtor)
+}
+
+func TestClassFileRoundTrip(t *testing.T) {
+	classes := codecClasses()
+	decoded, err := DecodeClasses(EncodeClasses(classes))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(decoded) != len(classes) {
+		t.Fatalf("decoded %d classes, want %d", len(decoded), len(classes))
+	}
+	for i := range classes {
+		if got, want := describe(decoded[i]), describe(classes[i]); got != want {
+			t.Errorf("class %d:\n got %s\nwant %s", i, got, want)
+		}
+	}
+}
+
+func TestOpenClassFile(t *testing.T) {
+	classes := codecClasses()
+	f, err := OpenClassFile(EncodeClasses(classes))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if f.Len() != len(classes) {
+		t.Fatalf("Len() = %d, want %d", f.Len(), len(classes))
+	}
+	for i := len(classes) - 1; i >= 0; i-- {
+		if f.Name(i) != classes[i].Name {
+			t.Errorf("Name(%d) = %q, want %q", i, f.Name(i), classes[i].Name)
+		}
+		class, err := f.Class(i)
+		if err != nil {
+			t.Fatalf("Class(%d): %v", i, err)
+		}
+		if got, want := describe(class), describe(classes[i]); got != want {
+			t.Errorf("Class(%d):\n got %s\nwant %s", i, got, want)
+		}
+	}
+}
+
+func TestDecodeClassesCorrupt(t *testing.T) {
+	data := EncodeClasses(codecClasses())
+	for n := 0; n < len(data); n++ {
+		if _, err := DecodeClasses(data[:n]); err == nil {
+			t.Fatalf("decoding the first %d of %d bytes succeeded", n, len(data))
+		}
+	}
+
+	wrongVersion := append([]byte(classFileMagic), byte(ClassFileVersion+1))
+	if _, err := DecodeClasses(wrongVersion); err == nil {
+		t.Error("decoding a newer version succeeded")
+	}
+}
+
+func BenchmarkDecodeClasses(b *testing.B) {
+	files, contents := loadCorpus(b)
+	var classes []Class
+	for i, c := range contents {
+		classes = append(classes, ParseSource(files[i], c)...)
+	}
+	data := EncodeClasses(classes)
+	b.SetBytes(int64(len(data)))
+	b.ReportAllocs()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		if _, err := DecodeClasses(data); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
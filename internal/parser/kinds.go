@@ -0,0 +1,185 @@
+package parser
+
+// Kind identifies a keyword, operator or punctuation token, so the parser
+// can compare tokens as integers instead of strings
+type Kind uint8
+
+const (
+	KindNone Kind = iota // identifiers, numbers, strings and EOF
+
+	// Keywords
+	KwClass
+	KwStruct
+	KwPublic
+	KwPrivate
+	KwProtected
+	KwNew
+	KwDelete
+	KwVirtual
+	KwConst
+	KwStatic
+	KwVoid
+	KwInt
+	KwChar
+	KwFloat
+	KwDouble
+	KwBool
+	KwLong
+	KwShort
+	KwUnsigned
+	KwSigned
+	KwIf
+	KwElse
+	KwFor
+	KwWhile
+	KwDo
+	KwReturn
+	KwNullptr
+	KwNULL
+	KwThis
+	KwTemplate
+	KwTypename
+	KwNamespace
+	KwUsing
+
+	// Operators
+	OpScope     // ::
+	OpArrow     // ->
+	OpEq        // ==
+	OpNotEq     // !=
+	OpLessEq    // <=
+	OpGreaterEq // >=
+	OpAndAnd    // &&
+	OpOrOr      // ||
+	OpInc       // ++
+	OpDec       // --
+	OpAddAssign // +=
+	OpSubAssign // -=
+	OpMulAssign // *=
+	OpDivAssign // /=
+	OpPlus      // +
+	OpMinus     // -
+	OpStar      // *
+	OpSlash     // /
+	OpAssign    // =
+	OpLess      // <
+	OpGreater   // >
+	OpNot       // !
+	OpAmp       // &
+	OpPipe      // |
+	OpCaret     // ^
+	OpPercent   // %
+	OpTilde     // ~
+
+	// Punctuation
+	PunctLBrace   // {
+	PunctRBrace   // }
+	PunctLParen   // (
+	PunctRParen   // )
+	PunctLBracket // [
+	PunctRBracket // ]
+	PunctSemi     // ;
+	PunctComma    // ,
+	PunctColon    // :
+	PunctDot      // .
+
+	numKinds
+)
+
+// kindText is the source spelling of each kind
+var kindText = [numKinds]string{
+	KwClass: "class", KwStruct: "struct", KwPublic: "public", KwPrivate: "private",
+	KwProtected: "protected", KwNew: "new", KwDelete: "delete", KwVirtual: "virtual",
+	KwConst: "const", KwStatic: "static", KwVoid: "void", KwInt: "int", KwChar: "char",
+	KwFloat: "float", KwDouble: "double", KwBool: "bool", KwLong: "long", KwShort: "short",
+	KwUnsigned: "unsigned", KwSigned: "signed", KwIf: "if", KwElse: "else", KwFor: "for",
+	KwWhile: "while", KwDo: "do", KwReturn: "return", KwNullptr: "nullptr", KwNULL: "NULL",
+	KwThis: "this", KwTemplate: "template", KwTypename: "typename", KwNamespace: "namespace",
+	KwUsing: "using",
+
+	OpScope: "::", OpArrow: "->", OpEq: "==", OpNotEq: "!=", OpLessEq: "<=", OpGreaterEq: ">=",
+	OpAndAnd: "&&", OpOrOr: "||", OpInc: "++", OpDec: "--", OpAddAssign: "+=", OpSubAssign: "-=",
+	OpMulAssign: "*=", OpDivAssign: "/=", OpPlus: "+", OpMinus: "-", OpStar: "*", OpSlash: "/",
+	OpAssign: "=", OpLess: "<", OpGreater: ">", OpNot: "!", OpAmp: "&", OpPipe: "|",
+	OpCaret: "^", OpPercent: "%", OpTilde: "~",
+
+	PunctLBrace: "{", PunctRBrace: "}", PunctLParen: "(", PunctRParen: ")",
+	PunctLBracket: "[", PunctRBracket: "]", PunctSemi: ";", PunctComma: ",",
+	PunctColon: ":", PunctDot: ".",
+}
+
+// String returns the source spelling of the kind
+func (k Kind) String() string {
+	if k < numKinds {
+		return kindText[k]
+	}
+	return ""
+}
+
+// keywords maps keyword spellings to their kinds
+var keywords = func() map[string]Kind {
+	m := make(map[string]Kind, OpScope-KwClass)
+	for k := KwClass; k < OpScope; k++ {
+		m[kindText[k]] = k
+	}
+	return m
+}()
+
+// singleCharKinds maps operator and punctuation bytes to their kinds
+var singleCharKinds = func() [256]Kind {
+	var t [256]Kind
+	for k := OpPlus; k < numKinds; k++ {
+		t[kindText[k][0]] = k
+	}
+	return t
+}()
+
+// twoCharOperator returns the kind of the two-byte operator a b, if any
+func twoCharOperator(a, b byte) Kind {
+	switch b {
+	case '=':
+		switch a {
+		case '=':
+			return OpEq
+		case '!':
+			return OpNotEq
+		case '<':
+			return OpLessEq
+		case '>':
+			return OpGreaterEq
+		case '+':
+			return OpAddAssign
+		case '-':
+			return OpSubAssign
+		case '*':
+			return OpMulAssign
+		case '/':
+			return OpDivAssign
+		}
+	case ':':
+		if a == ':' {
+			return OpScope
+		}
+	case '>':
+		if a == '-' {
+			return OpArrow
+		}
+	case '&':
+		if a == '&' {
+			return OpAndAnd
+		}
+	case '|':
+		if a == '|' {
+			return OpOrOr
+		}
+	case '+':
+		if a == '+' {
+			return OpInc
+		}
+	case '-':
+		if a == '-' {
+			return OpDec
+		}
+	}
+	return KindNone
+}
@@ -1,90 +1,189 @@
 package parser
 
 import (
-	"strings"
+	"bytes"
+	"math"
+	"time"
 	"unicode"
 )
 
-var keywords = map[string]bool{
-	"class": true, "struct": true, "public": true, "private": true, "protected": true,
-	"new": true, "delete": true, "virtual": true, "const": true, "static": true,
-	"void": true, "int": true, "char": true, "float": true, "double": true,
-	"bool": true, "long": true, "short": true, "unsigned": true, "signed": true,
-	"if": true, "else": true, "for": true, "while": true, "do": true,
-	"return": true, "nullptr": true, "NULL": true, "this": true,
-	"template": true, "typename": true, "namespace": true, "using": true,
-}
+// Byte classes used by the lexer's lookup table
+const (
+	classSpace      uint8 = 1 << iota // ' ', \t, \r, \n
+	classIdentStart                   // may start an identifier
+	classIdent                        // may continue an identifier
+	classDigit                        // may start a number
+	classNumber                       // may continue a number
+	classOperator                     // single-byte operator
+	classPunct                        // punctuation
+)
+
+// byteClass maps every byte to its lexical classes. Letters follow
+// unicode.IsLetter on the byte value, so non-ASCII bytes are classified
+// exactly as they were before the table existed.
+var byteClass = func() [256]uint8 {
+	var t [256]uint8
+	for i := 0; i < 256; i++ {
+		ch := byte(i)
+		letter := unicode.IsLetter(rune(ch))
+		digit := unicode.IsDigit(rune(ch))
+		if ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' {
+			t[i] |= classSpace
+		}
+		if letter || ch == '_' {
+			t[i] |= classIdentStart
+		}
+		if letter || digit || ch == '_' {
+			t[i] |= classIdent
+		}
+		if digit {
+			t[i] |= classDigit | classNumber
+		}
+		if ch == '.' || ch == 'x' || ch == 'X' || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F') {
+			t[i] |= classNumber
+		}
+		if k := singleCharKinds[ch]; k >= OpPlus && k <= OpTilde {
+			t[i] |= classOperator
+		} else if k >= PunctLBrace {
+			t[i] |= classPunct
+		}
+	}
+	return t
+}()
 
 // Lexer tokenizes C++ source code
 type Lexer struct {
-	input  string
-	pos    int
-	line   int
-	column int
-	tokens []Token
+	input     []byte
+	pos       int
+	line      int
+	lineStart int // offset of the first byte of the current line
+	tokens    []Token
+
+	directives int // preprocessor directives skipped so far
+	includes   []string
+
+	// Budget (see Limits): once Next has been called more than checkAt
+	// times it checks the limits, and past one it only returns EOF
+	scanned   int
+	checkAt   int
+	maxTokens int
+	deadline  time.Time
+	timeout   time.Duration
+	err       error
+}
+
+// NewLexer creates a new lexer for the given input.
+// Tokens refer to input by offset, so it must not be modified while
+// the tokens are in use.
+func NewLexer(input []byte) *Lexer {
+	return newLexer(input, make([]Token, 0, estimateTokens(len(input))))
 }
 
-// NewLexer creates a new lexer for the given input
-func NewLexer(input string) *Lexer {
+// newLexer creates a lexer that appends tokens to buf
+func newLexer(input []byte, buf []Token) *Lexer {
 	return &Lexer{
-		input:  input,
-		pos:    0,
-		line:   1,
-		column: 1,
+		input:   input,
+		pos:     0,
+		line:    1,
+		tokens:  buf,
+		checkAt: math.MaxInt,
 	}
 }
 
 // Tokenize processes the entire input and returns all tokens
 func (l *Lexer) Tokenize() []Token {
-	for l.pos < len(l.input) {
+	for {
+		tok := l.Next()
+		l.tokens = append(l.tokens, tok)
+		if tok.Type == TokenEOF {
+			return l.tokens
+		}
+	}
+}
+
+// Next scans and returns the next token. At the end of input it
+// returns a TokenEOF token, and keeps returning it on further calls.
+func (l *Lexer) Next() Token {
+	if l.scanned++; l.scanned > l.checkAt && l.overBudget() {
+		l.pos = len(l.input)
+		return l.token(TokenEOF, KindNone, 0)
+	}
+	for {
 		l.skipWhitespaceAndComments()
 		if l.pos >= len(l.input) {
-			break
+			return l.token(TokenEOF, KindNone, 0)
 		}
 
 		ch := l.input[l.pos]
+		class := byteClass[ch]
 
 		// Check for :: scope operator before treating : as punctuation
 		if ch == ':' && l.peek() == ':' {
-			l.addToken(TokenOperator, "::")
-			l.advance()
-			l.advance()
-			continue
+			return l.token(TokenOperator, OpScope, 2)
 		}
 
 		switch {
 		case ch == '"' || ch == '\'':
-			l.readString(ch)
+			return l.readString(ch)
 		case ch == '#':
 			l.skipPreprocessor()
-		case unicode.IsLetter(rune(ch)) || ch == '_':
-			l.readIdentifier()
-		case unicode.IsDigit(rune(ch)):
-			l.readNumber()
-		case l.isOperator(ch):
-			l.readOperator()
-		case l.isPunctuation(ch):
-			l.addToken(TokenPunctuation, string(ch))
-			l.advance()
+		case class&classIdentStart != 0:
+			return l.readIdentifier()
+		case class&classDigit != 0:
+			return l.readNumber()
+		case class&classOperator != 0:
+			return l.readOperator()
+		case class&classPunct != 0:
+			return l.token(TokenPunctuation, singleCharKinds[ch], 1)
 		default:
-			l.advance()
+			l.pos++
 		}
 	}
+}
 
-	l.tokens = append(l.tokens, Token{Type: TokenEOF, Line: l.line, Column: l.column})
-	return l.tokens
+// resumeAfter moves the lexer to just past tok, which it produced
+// earlier, so tokens after it can be scanned again or skipped
+func (l *Lexer) resumeAfter(tok Token) {
+	l.pos = int(tok.Start + tok.Len)
+	l.line = int(tok.Line)
+	l.lineStart = int(tok.Start - tok.Column + 1)
 }
 
-func (l *Lexer) advance() {
-	if l.pos < len(l.input) {
-		if l.input[l.pos] == '\n' {
-			l.line++
-			l.column = 1
-		} else {
-			l.column++
+// skipBlock skips the rest of a brace-delimited block whose opening
+// brace was the last token scanned, without producing any tokens.
+// If the block contains a token for which keep returns true, or a
+// preprocessor directive (an #if branch can unbalance the braces), the
+// lexer is left where it was and skipBlock returns false.
+func (l *Lexer) skipBlock(keep func(Kind) bool) bool {
+	pos, line, lineStart, directives := l.pos, l.line, l.lineStart, l.directives
+
+	depth := 1
+	for depth > 0 {
+		tok := l.Next()
+		if l.directives != directives || keep(tok.Kind) {
+			l.pos, l.line, l.lineStart, l.directives = pos, line, lineStart, directives
+			return false
 		}
-		l.pos++
+		switch {
+		case tok.Type == TokenEOF:
+			return true
+		case tok.Kind == PunctLBrace:
+			depth++
+		case tok.Kind == PunctRBrace:
+			depth--
+		}
+	}
+	return true
+}
+
+// skipTo moves to offset end, counting the newlines skipped on the way
+func (l *Lexer) skipTo(end int) {
+	chunk := l.input[l.pos:end]
+	if n := bytes.Count(chunk, []byte{'\n'}); n > 0 {
+		l.line += n
+		l.lineStart = l.pos + bytes.LastIndexByte(chunk, '\n') + 1
 	}
+	l.pos = end
 }
 
 func (l *Lexer) peek() byte {
@@ -98,25 +197,29 @@ func (l *Lexer) skipWhitespaceAndComments() {
 	for l.pos < len(l.input) {
 		ch := l.input[l.pos]
 
-		if ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' {
-			l.advance()
+		if byteClass[ch]&classSpace != 0 {
+			// Whitespace run, counting lines as we go
+			for l.pos < len(l.input) && byteClass[l.input[l.pos]]&classSpace != 0 {
+				if l.input[l.pos] == '\n' {
+					l.line++
+					l.lineStart = l.pos + 1
+				}
+				l.pos++
+			}
 		} else if ch == '/' && l.peek() == '/' {
-			// Single-line comment
-			for l.pos < len(l.input) && l.input[l.pos] != '\n' {
-				l.advance()
+			// Single-line comment, up to but not including the newline
+			if i := bytes.IndexByte(l.input[l.pos:], '\n'); i >= 0 {
+				l.pos += i
+			} else {
+				l.pos = len(l.input)
 			}
 		} else if ch == '/' && l.peek() == '*' {
-			// Multi-line comment
-			l.advance() // skip /
-			l.advance() // skip *
-			for l.pos < len(l.input)-1 {
-				if l.input[l.pos] == '*' && l.peek() == '/' {
-					l.advance() // skip *
-					l.advance() // skip /
-					break
-				}
-				l.advance()
+			// Multi-line comment; an unterminated one runs to the end of input
+			end := len(l.input)
+			if i := bytes.Index(l.input[l.pos+2:], []byte("*/")); i >= 0 {
+				end = l.pos + 2 + i + 2
 			}
+			l.skipTo(end)
 		} else {
 			break
 		}
@@ -124,155 +227,166 @@ func (l *Lexer) skipWhitespaceAndComments() {
 }
 
 func (l *Lexer) skipPreprocessor() {
-	// Skip preprocessor directives (lines starting with #)
-	for l.pos < len(l.input) && l.input[l.pos] != '\n' {
-		// Handle line continuation
-		if l.input[l.pos] == '\\' && l.peek() == '\n' {
-			l.advance()
-			l.advance()
-			continue
+	// Skip preprocessor directives (lines starting with #),
+	// following line continuations
+	l.directives++
+	l.readInclude()
+	for {
+		i := bytes.IndexByte(l.input[l.pos:], '\n')
+		if i < 0 {
+			l.pos = len(l.input)
+			return
 		}
-		l.advance()
+		nl := l.pos + i
+		if nl == l.pos || l.input[nl-1] != '\\' {
+			l.skipTo(nl)
+			return
+		}
+		l.skipTo(nl + 1)
 	}
 }
 
-func (l *Lexer) readString(quote byte) {
+// includeDirectives are the directives whose target readInclude records
+var includeDirectives = []string{"include", "include_next", "import"}
+
+// readInclude records the target of an #include directive starting at the
+// current '#', as written between the quotes or angle brackets
+func (l *Lexer) readInclude() {
+	i := l.skipBlanks(l.pos + 1)
+	directive := ""
+	for _, d := range includeDirectives {
+		if bytes.HasPrefix(l.input[i:], []byte(d)) && (i+len(d) == len(l.input) || byteClass[l.input[i+len(d)]]&classIdent == 0) {
+			directive = d
+			break
+		}
+	}
+	if directive == "" {
+		return
+	}
+	i = l.skipBlanks(i + len(directive))
+	if i >= len(l.input) || l.input[i] != '"' && l.input[i] != '<' {
+		return // a macro naming the header
+	}
+	closing := byte('"')
+	if l.input[i] == '<' {
+		closing = '>'
+	}
+	end := bytes.IndexAny(l.input[i+1:], string([]byte{closing, '\n'}))
+	if end <= 0 || l.input[i+1+end] != closing {
+		return
+	}
+	target := l.input[i+1 : i+1+end]
+	// Look-ahead can rescan a directive, so record each target once
+	for _, seen := range l.includes {
+		if seen == string(target) {
+			return
+		}
+	}
+	l.includes = append(l.includes, Symbols.InternBytes(target))
+}
+
+// skipBlanks returns the offset of the first byte at or after i that is
+// not a space or tab
+func (l *Lexer) skipBlanks(i int) int {
+	for i < len(l.input) && (l.input[i] == ' ' || l.input[i] == '\t') {
+		i++
+	}
+	return i
+}
+
+// Includes returns the #include targets scanned so far, in order of first
+// appearance
+func (l *Lexer) Includes() []string {
+	return l.includes
+}
+
+func (l *Lexer) readString(quote byte) Token {
 	startLine := l.line
-	startCol := l.column
-	var sb strings.Builder
-	sb.WriteByte(quote)
-	l.advance() // skip opening quote
+	startCol := l.column()
+	start := l.pos
+	l.pos++ // skip opening quote
 
 	for l.pos < len(l.input) {
 		ch := l.input[l.pos]
 		if ch == '\\' && l.pos+1 < len(l.input) {
-			sb.WriteByte(ch)
-			l.advance()
-			if l.pos < len(l.input) {
-				sb.WriteByte(l.input[l.pos])
-				l.advance()
+			if l.input[l.pos+1] == '\n' {
+				l.line++
+				l.lineStart = l.pos + 2
 			}
+			l.pos += 2
 		} else if ch == quote {
-			sb.WriteByte(ch)
-			l.advance()
+			l.pos++
 			break
 		} else if ch == '\n' {
 			break // Unterminated string
 		} else {
-			sb.WriteByte(ch)
-			l.advance()
+			l.pos++
 		}
 	}
 
-	l.tokens = append(l.tokens, Token{
+	return Token{
 		Type:   TokenString,
-		Value:  sb.String(),
-		Line:   startLine,
-		Column: startCol,
-	})
+		Start:  int32(start),
+		Len:    int32(l.pos - start),
+		Line:   int32(startLine),
+		Column: int32(startCol),
+	}
 }
 
-func (l *Lexer) readIdentifier() {
-	startLine := l.line
-	startCol := l.column
+func (l *Lexer) readIdentifier() Token {
 	start := l.pos
-
-	for l.pos < len(l.input) {
-		ch := l.input[l.pos]
-		if unicode.IsLetter(rune(ch)) || unicode.IsDigit(rune(ch)) || ch == '_' {
-			l.advance()
-		} else {
-			break
-		}
+	end := start + 1
+	for end < len(l.input) && byteClass[l.input[end]]&classIdent != 0 {
+		end++
 	}
 
-	value := l.input[start:l.pos]
+	// Indexing with a converted []byte does not allocate
 	tokenType := TokenIdent
-	if keywords[value] {
+	kind, isKeyword := keywords[string(l.input[start:end])]
+	if isKeyword {
 		tokenType = TokenKeyword
 	}
 
-	l.tokens = append(l.tokens, Token{
-		Type:   tokenType,
-		Value:  value,
-		Line:   startLine,
-		Column: startCol,
-	})
+	return l.token(tokenType, kind, end-start)
 }
 
-func (l *Lexer) readNumber() {
-	startLine := l.line
-	startCol := l.column
+func (l *Lexer) readNumber() Token {
 	start := l.pos
-
-	for l.pos < len(l.input) {
-		ch := l.input[l.pos]
-		if unicode.IsDigit(rune(ch)) || ch == '.' || ch == 'x' || ch == 'X' ||
-			(ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F') {
-			l.advance()
-		} else {
-			break
-		}
+	end := start + 1
+	for end < len(l.input) && byteClass[l.input[end]]&classNumber != 0 {
+		end++
 	}
 
-	l.tokens = append(l.tokens, Token{
-		Type:   TokenNumber,
-		Value:  l.input[start:l.pos],
-		Line:   startLine,
-		Column: startCol,
-	})
+	return l.token(TokenNumber, KindNone, end-start)
 }
 
-func (l *Lexer) isOperator(ch byte) bool {
-	return ch == '+' || ch == '-' || ch == '*' || ch == '/' || ch == '=' ||
-		ch == '<' || ch == '>' || ch == '!' || ch == '&' || ch == '|' ||
-		ch == '^' || ch == '%' || ch == '~'
-}
-
-func (l *Lexer) readOperator() {
-	startLine := l.line
-	startCol := l.column
-	start := l.pos
-
+func (l *Lexer) readOperator() Token {
 	// Handle multi-character operators
 	if l.pos+1 < len(l.input) {
-		two := l.input[l.pos : l.pos+2]
-		if two == "::" || two == "->" || two == "==" || two == "!=" ||
-			two == "<=" || two == ">=" || two == "&&" || two == "||" ||
-			two == "++" || two == "--" || two == "+=" || two == "-=" ||
-			two == "*=" || two == "/=" {
-			l.advance()
-			l.advance()
-			l.tokens = append(l.tokens, Token{
-				Type:   TokenOperator,
-				Value:  two,
-				Line:   startLine,
-				Column: startCol,
-			})
-			return
+		if kind := twoCharOperator(l.input[l.pos], l.input[l.pos+1]); kind != KindNone {
+			return l.token(TokenOperator, kind, 2)
 		}
 	}
 
-	l.advance()
-	l.tokens = append(l.tokens, Token{
-		Type:   TokenOperator,
-		Value:  l.input[start:l.pos],
-		Line:   startLine,
-		Column: startCol,
-	})
+	return l.token(TokenOperator, singleCharKinds[l.input[l.pos]], 1)
 }
 
-func (l *Lexer) isPunctuation(ch byte) bool {
-	return ch == '{' || ch == '}' || ch == '(' || ch == ')' ||
-		ch == '[' || ch == ']' || ch == ';' || ch == ',' ||
-		ch == ':' || ch == '.'
+// column returns the 1-based column of the current position
+func (l *Lexer) column() int {
+	return l.pos - l.lineStart + 1
 }
 
-func (l *Lexer) addToken(tokenType TokenType, value string) {
-	l.tokens = append(l.tokens, Token{
+// token returns a token of length n starting at the current position
+// and moves past it. Tokens other than strings never span lines.
+func (l *Lexer) token(tokenType TokenType, kind Kind, n int) Token {
+	tok := Token{
 		Type:   tokenType,
-		Value:  value,
-		Line:   l.line,
-		Column: l.column,
-	})
+		Kind:   kind,
+		Start:  int32(l.pos),
+		Len:    int32(n),
+		Line:   int32(l.line),
+		Column: int32(l.column()),
+	}
+	l.pos += n
+	return tok
 }
@@ -0,0 +1,87 @@
+package parser
+
+import (
+	"fmt"
+	"math"
+	"time"
+)
+
+// Limits bounds the work spent parsing one file, so a pathological input
+// (a huge generated file, or one the parser misreads) cannot stall a run.
+// Zero fields are unlimited.
+type Limits struct {
+	MaxBytes  int           // source size
+	MaxTokens int           // tokens lexed, including bodies skipped unparsed
+	Timeout   time.Duration // parse time
+}
+
+// LimitError reports a file that was not parsed because it went over one
+// of its Limits
+type LimitError struct {
+	Limit string // "bytes", "tokens" or "timeout"
+	Max   string // the limit, for display
+}
+
+func (e *LimitError) Error() string {
+	return fmt.Sprintf("exceeds the %s limit", e.Max)
+}
+
+// CheckSize returns a *LimitError if n bytes of source are over MaxBytes
+func (l Limits) CheckSize(n int) error {
+	if l.MaxBytes > 0 && n > l.MaxBytes {
+		return &LimitError{Limit: "bytes", Max: fmt.Sprintf("%d-byte", l.MaxBytes)}
+	}
+	return nil
+}
+
+// budgetInterval is the number of tokens lexed between deadline checks
+const budgetInterval = 4096
+
+// ParseSourceLimited is ParseSourceTokens within limits. A file that goes
+// over a limit yields no classes and a *LimitError.
+func ParseSourceLimited(filename string, content []byte, limits Limits) ([]Class, int, error) {
+	if err := limits.CheckSize(len(content)); err != nil {
+		return nil, 0, err
+	}
+
+	lexer := newLexer(content, nil)
+	lexer.maxTokens = limits.MaxTokens
+	if limits.Timeout > 0 {
+		lexer.deadline = time.Now().Add(limits.Timeout)
+		lexer.timeout = limits.Timeout
+	}
+	if limits.MaxTokens > 0 || limits.Timeout > 0 {
+		lexer.checkAt = 0
+	}
+
+	classes, tokens := parseWith(filename, content, lexer)
+	if lexer.err != nil {
+		return nil, tokens, lexer.err
+	}
+	return classes, tokens, nil
+}
+
+// overBudget reports whether the lexer went over its token limit or
+// deadline, and if not, schedules the next check
+func (l *Lexer) overBudget() bool {
+	if l.err == nil {
+		switch {
+		case l.maxTokens > 0 && l.scanned > l.maxTokens:
+			l.err = &LimitError{Limit: "tokens", Max: fmt.Sprintf("%d-token", l.maxTokens)}
+		case !l.deadline.IsZero() && time.Now().After(l.deadline):
+			l.err = &LimitError{Limit: "timeout", Max: l.timeout.String() + " parse time"}
+		}
+	}
+	if l.err != nil {
+		return true
+	}
+
+	l.checkAt = math.MaxInt
+	if !l.deadline.IsZero() {
+		l.checkAt = l.scanned + budgetInterval
+	}
+	if l.maxTokens > 0 {
+		l.checkAt = min(l.checkAt, l.maxTokens)
+	}
+	return false
+}
@@ -0,0 +1,30 @@
+package parser
+
+import (
+	"errors"
+	"testing"
+)
+
+func TestParseSourceLimited(t *testing.T) {
+	content := []byte(bufferSource)
+	if _, _, err := ParseSourceLimited("buffer.cpp", content, Limits{}); err != nil {
+		t.Fatalf("unlimited parse: %v", err)
+	}
+
+	for _, tc := range []struct {
+		limits Limits
+		limit  string
+	}{
+		{Limits{MaxBytes: 10}, "bytes"},
+		{Limits{MaxTokens: 10}, "tokens"},
+	} {
+		classes, _, err := ParseSourceLimited("buffer.cpp", content, tc.limits)
+		var limitErr *LimitError
+		if !errors.As(err, &limitErr) || limitErr.Limit != tc.limit {
+			t.Errorf("%+v: err = %v, want a %s LimitError", tc.limits, err, tc.limit)
+		}
+		if classes != nil {
+			t.Errorf("%+v: got classes from a file over the limit", tc.limits)
+		}
+	}
+}
@@ -0,0 +1,15 @@
+//go:build !linux && !darwin
+
+package parser
+
+import (
+	"errors"
+	"os"
+)
+
+// mmapFile is not supported on this platform; ReadSource falls back to reads
+func mmapFile(f *os.File, size int) ([]byte, error) {
+	return nil, errors.New("mmap not supported")
+}
+
+func munmapFile(data []byte) {}
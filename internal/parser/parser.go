@@ -1,79 +1,271 @@
 package parser
 
 import (
-	"os"
 	"path/filepath"
 	"strings"
 )
 
-// Parser parses C++ source files and extracts class information
+// Parser parses C++ source files and extracts class information.
+// Tokens are pulled from the lexer only as the parser reaches them.
 type Parser struct {
-	tokens  []Token
-	pos     int
-	file    string
-	classes []Class
+	src      []byte
+	lexer    *Lexer
+	tokens   []Token // tokens lexed so far
+	lexedAll bool    // true once the EOF token is in tokens
+	pos      int
+	file     string
+	classes  []Class
+	// classIndex maps a qualified class name to its first entry in
+	// classes, and classNames an unqualified one
+	classIndex map[classKey]int
+	classNames map[string]int
+
+	// scopes holds the namespace of each brace block open at file scope,
+	// innermost last. A namespace head sets nextNamespace for the brace
+	// that follows it.
+	scopes        []string
+	nextNamespace string
+	namespaceHead bool
+
+	// Forward scans shared by the look-ahead probes at successive positions
+	scopeScan scan // next ::, ;, { or } (isOutOfClassMethod)
+	declScan  scan // next ;, ( or { (classifyDeclaration)
+	starScan  scan // next * before declScan's stop
+	identScan scan // next identifier before declScan's stop
+	callScan  scan // next ;, (, { or } (classifyDeclaration)
+}
+
+// scan caches the result of a forward search for a stop token: tokens
+// from..stop-1 are not stops and tokens[stop] is one (or EOF). A probe at
+// any position in between reuses the result instead of rescanning.
+type scan struct {
+	from, stop int
+	valid      bool
+}
+
+// nextStop returns the index of the first token at or after pos that
+// isStop accepts, or of the EOF token
+func (p *Parser) nextStop(s *scan, pos int, isStop func(Token) bool) int {
+	if s.valid && s.from <= pos && pos <= s.stop {
+		return s.stop
+	}
+	i := pos
+	for tok := p.at(i); tok.Type != TokenEOF && !isStop(tok); tok = p.at(i) {
+		i++
+	}
+	*s = scan{from: pos, stop: i, valid: true}
+	return i
+}
+
+// resetScans drops the cached scans, whose positions refer to tokens
+// that are about to be discarded
+func (p *Parser) resetScans() {
+	p.scopeScan, p.declScan, p.starScan, p.identScan, p.callScan = scan{}, scan{}, scan{}, scan{}, scan{}
 }
 
 // ParseFile parses a single C++ file
 func ParseFile(filename string) ([]Class, error) {
-	content, err := os.ReadFile(filename)
+	content, release, err := ReadSource(filename)
 	if err != nil {
 		return nil, err
 	}
+	defer release()
+	return ParseSource(filename, content), nil
+}
+
+// ParseSource parses C++ source that was already read from filename.
+// The returned classes do not refer to content.
+func ParseSource(filename string, content []byte) []Class {
+	classes, _ := ParseSourceTokens(filename, content)
+	return classes
+}
 
+// ParseSourceTokens is ParseSource that also returns the number of tokens
+// lexed. Bodies the parser skips without lexing are not counted.
+func ParseSourceTokens(filename string, content []byte) ([]Class, int) {
+	return parseWith(filename, content, newLexer(content, nil))
+}
+
+// parseWith parses content, pulling tokens from lexer. The parser keeps
+// its own token buffer, so the lexer needs none.
+func parseWith(filename string, content []byte, lexer *Lexer) ([]Class, int) {
 	absPath, _ := filepath.Abs(filename)
-	lexer := NewLexer(string(content))
-	tokens := lexer.Tokenize()
 
 	parser := &Parser{
-		tokens: tokens,
+		src:    content,
+		lexer:  lexer,
+		tokens: getTokenBuffer(len(content)),
 		pos:    0,
 		file:   absPath,
 	}
+	// Classes only hold copied strings, so the buffer can be reused
+	defer func() { putTokenBuffer(parser.tokens) }()
 
-	return parser.parse(), nil
+	classes := parser.parse()
+	includes := parser.lexer.Includes()
+	for i := range classes {
+		classes[i].Includes = includes
+		classes[i].SetFile(classes[i].File)
+	}
+	return classes, len(parser.tokens)
 }
 
 func (p *Parser) parse() []Class {
 	// First pass: parse inline class definitions
 	for !p.isAtEnd() {
-		if p.matchKeyword("class") || p.matchKeyword("struct") {
+		if p.matchKind(KwClass) || p.matchKind(KwStruct) {
 			if class := p.parseClass(); class != nil {
-				p.classes = append(p.classes, *class)
+				p.addClass(*class)
 			}
+		} else if p.checkKind(KwNamespace) {
+			p.parseNamespaceHead()
 		} else if p.isOutOfClassMethod() {
 			// Parse out-of-class method definitions (ClassName::MethodName)
 			p.parseOutOfClassMethod()
+		} else if p.isFreeFunctionBody() {
+			p.skipFreeFunctionBody()
 		} else {
+			switch p.current().Kind {
+			case PunctLBrace:
+				p.enterBlock()
+			case PunctRBrace:
+				p.leaveBlock()
+			case PunctSemi:
+				p.namespaceHead = false // using namespace, or an alias
+			}
 			p.advance()
 		}
 	}
 	return p.classes
 }
 
+// parseNamespaceHead reads the name after "namespace" (possibly nested, as
+// in "namespace a::b"), which the next brace opens. Anonymous and inline
+// namespaces add no name: classes in the first are file-local anyway, and
+// names in the second are found without it.
+func (p *Parser) parseNamespaceHead() {
+	inline := p.pos > 0 && p.textIs(p.tokens[p.pos-1], "inline")
+	p.advance()
+	namespace := p.namespace()
+	for p.check(TokenIdent) {
+		if !inline {
+			namespace = joinScope(namespace, p.text(p.current()))
+		}
+		p.advance()
+		if !p.matchKind(OpScope) {
+			break
+		}
+	}
+	p.nextNamespace, p.namespaceHead = namespace, true
+}
+
+// enterBlock records a brace opened at file scope: a namespace body if a
+// namespace head precedes it, any other block otherwise
+func (p *Parser) enterBlock() {
+	namespace := p.namespace()
+	if p.namespaceHead {
+		namespace = p.nextNamespace
+	}
+	p.scopes = append(p.scopes, namespace)
+	p.namespaceHead = false
+}
+
+// leaveBlock records a brace closed at file scope. Braces in #if branches
+// need not balance, so an unmatched one is ignored.
+func (p *Parser) leaveBlock() {
+	if len(p.scopes) > 0 {
+		p.scopes = p.scopes[:len(p.scopes)-1]
+	}
+	p.namespaceHead = false
+}
+
+// namespace returns the namespace of the current file-scope position
+func (p *Parser) namespace() string {
+	if len(p.scopes) == 0 {
+		return ""
+	}
+	return p.scopes[len(p.scopes)-1]
+}
+
+// joinScope returns name qualified by scope, interned
+func joinScope(scope, name string) string {
+	if scope == "" || name == "" {
+		return scope + name
+	}
+	return Symbols.InternString(scope + "::" + name)
+}
+
+// addClass appends class to the parsed classes and returns its index.
+// Out-of-class methods attach to the first class registered under a name.
+func (p *Parser) addClass(class Class) int {
+	if p.classIndex == nil {
+		p.classIndex = make(map[classKey]int)
+		p.classNames = make(map[string]int)
+	}
+	idx := len(p.classes)
+	p.classes = append(p.classes, class)
+	if _, exists := p.classIndex[keyOf(&class)]; !exists {
+		p.classIndex[keyOf(&class)] = idx
+	}
+	if _, exists := p.classNames[class.Name]; !exists {
+		p.classNames[class.Name] = idx
+	}
+	return idx
+}
+
+// findClass returns the first class of the file that a definition of
+// qualifier::name inside namespace refers to. As in C++ name lookup the
+// enclosing namespaces are tried from the innermost out; failing that, a
+// class of that name in any namespace is taken, since the definition may
+// rely on a using-directive.
+func (p *Parser) findClass(namespace, qualifier, name string) (int, bool) {
+	for scope := namespace; ; {
+		if idx, ok := p.classIndex[classKey{joinScope(scope, qualifier), name}]; ok {
+			return idx, true
+		}
+		if scope == "" {
+			break
+		}
+		if i := strings.LastIndex(scope, "::"); i >= 0 {
+			scope = scope[:i]
+		} else {
+			scope = ""
+		}
+	}
+	idx, ok := p.classNames[name]
+	return idx, ok
+}
+
 // isOutOfClassMethod checks for pattern: Type ClassName::MethodName(
 func (p *Parser) isOutOfClassMethod() bool {
-	// Look for :: operator followed by ( within reasonable distance
-	for i := 0; i < 10 && p.pos+i < len(p.tokens); i++ {
-		tok := p.tokens[p.pos+i]
-		if tok.Value == "::" {
+	// Look for :: operator followed by ( within reasonable distance. The
+	// first ::, ;, { or } is shared by every position before it.
+	end := p.pos + 10
+	i := p.nextStop(&p.scopeScan, p.pos, isScopeStop)
+	for i < end {
+		tok := p.at(i)
+		if tok.Kind == OpScope {
 			// Found ::, look for ( after it
-			for j := i + 1; j < i+5 && p.pos+j < len(p.tokens); j++ {
-				if p.tokens[p.pos+j].Value == "(" {
+			for j := i + 1; j < i+5; j++ {
+				if kind := p.at(j).Kind; kind == PunctLParen {
 					return true
-				}
-				if p.tokens[p.pos+j].Value == ";" {
+				} else if kind == PunctSemi {
 					return false
 				}
 			}
 		}
-		if tok.Value == ";" || tok.Value == "{" || tok.Value == "}" {
+		if tok.Kind == PunctSemi || tok.Kind == PunctLBrace || tok.Kind == PunctRBrace {
 			return false
 		}
+		i++
 	}
 	return false
 }
 
+func isScopeStop(tok Token) bool {
+	return tok.Kind == OpScope || tok.Kind == PunctSemi || tok.Kind == PunctLBrace || tok.Kind == PunctRBrace
+}
+
 // parseOutOfClassMethod parses ClassName::MethodName() { ... } definitions
 func (p *Parser) parseOutOfClassMethod() {
 	startPos := p.pos
@@ -84,23 +276,34 @@ func (p *Parser) parseOutOfClassMethod() {
 		}
 	}()
 
-	startLine := p.current().Line
+	startLine := p.line()
 
 	// Collect tokens until we find ::
-	var className string
-	for !p.isAtEnd() && !p.checkValue("::") {
+	classTok := -1
+	for !p.isAtEnd() && !p.checkKind(OpScope) {
 		if p.check(TokenIdent) {
-			className = p.current().Value // Last ident before :: is class name
+			classTok = p.pos // Last ident before :: is class name
 		}
 		p.advance()
 	}
 
-	if className == "" || !p.matchValue("::") {
+	if classTok < 0 || !p.matchKind(OpScope) {
 		return
 	}
+	className := p.text(p.tokens[classTok])
+
+	// Further qualification, as in ns::Class::method, names the class's
+	// namespace; the class is the last name before the method
+	qualifier := ""
+	for p.check(TokenIdent) && p.peekAt(1).Kind == OpScope {
+		qualifier = joinScope(qualifier, className)
+		className = p.text(p.current())
+		p.advance()
+		p.advance()
+	}
 
 	// Check for destructor (~)
-	isDestructor := p.checkValue("~")
+	isDestructor := p.checkKind(OpTilde)
 	if isDestructor {
 		p.advance()
 	}
@@ -109,33 +312,33 @@ func (p *Parser) parseOutOfClassMethod() {
 	if !p.check(TokenIdent) {
 		return
 	}
-	methodName := p.current().Value
+	methodName := p.text(p.current())
 	p.advance()
 
 	// Skip parameters
-	if !p.matchValue("(") {
+	if !p.matchKind(PunctLParen) {
 		return
 	}
 	parenCount := 1
 	for !p.isAtEnd() && parenCount > 0 {
-		if p.checkValue("(") {
+		if p.checkKind(PunctLParen) {
 			parenCount++
-		} else if p.checkValue(")") {
+		} else if p.checkKind(PunctRParen) {
 			parenCount--
 		}
 		p.advance()
 	}
 
 	// Skip initializer list for constructors
-	if p.checkValue(":") && !isDestructor {
+	if p.checkKind(PunctColon) && !isDestructor {
 		p.advance()
-		for !p.isAtEnd() && !p.checkValue("{") && !p.checkValue(";") {
+		for !p.isAtEnd() && !p.checkKind(PunctLBrace) && !p.checkKind(PunctSemi) {
 			p.advance()
 		}
 	}
 
 	// Parse body
-	if !p.checkValue("{") {
+	if !p.checkKind(PunctLBrace) {
 		return
 	}
 
@@ -148,26 +351,20 @@ func (p *Parser) parseOutOfClassMethod() {
 	p.parseFunctionBody(fn)
 
 	// Find or create class to attach this method to
-	var targetClass *Class
-	for i := range p.classes {
-		if p.classes[i].Name == className {
-			targetClass = &p.classes[i]
-			break
-		}
-	}
-
-	if targetClass == nil {
+	idx, exists := p.findClass(p.namespace(), qualifier, className)
+	if !exists {
 		// Create a placeholder class for this method
-		newClass := Class{
-			Name:    className,
-			File:    p.file,
-			Methods: []Function{},
-		}
-		p.classes = append(p.classes, newClass)
-		targetClass = &p.classes[len(p.classes)-1]
+		idx = p.addClass(Class{
+			Name:      className,
+			Namespace: joinScope(p.namespace(), qualifier),
+			File:      p.file,
+			Methods:   []Function{},
+		})
 	}
 
-	// Attach method to class
+	// Attach method to class. The pointer is taken only after the last
+	// append to p.classes, so it cannot point into a stale array.
+	targetClass := &p.classes[idx]
 	if isDestructor {
 		targetClass.Destructor = fn
 	} else if methodName == className {
@@ -177,32 +374,88 @@ func (p *Parser) parseOutOfClassMethod() {
 	}
 }
 
+// isFreeFunctionBody reports whether the current token is the opening
+// brace of a function body at file scope: { after ')', optionally
+// followed by a qualifier such as const, noexcept or override, in a
+// statement that is not a namespace or class head (these can end with
+// a macro call, as in "namespace std _GLIBCXX_VISIBILITY(default) {")
+func (p *Parser) isFreeFunctionBody() bool {
+	if !p.checkKind(PunctLBrace) || p.pos == 0 {
+		return false
+	}
+	paren := p.pos - 1
+	if prev := p.tokens[paren]; prev.Kind == KwConst || prev.Type == TokenIdent {
+		paren--
+	}
+	if paren < 0 || p.tokens[paren].Kind != PunctRParen {
+		return false
+	}
+
+	for i := paren - 1; i >= 0; i-- {
+		switch p.tokens[i].Kind {
+		case PunctSemi, PunctLBrace, PunctRBrace:
+			return true
+		case KwNamespace, KwClass, KwStruct:
+			return false
+		}
+	}
+	return true
+}
+
+// skipFreeFunctionBody skips a file-scope function body without lexing
+// it, unless it contains something the parser could pick up at file
+// scope: a new or delete, or a local class
+func (p *Parser) skipFreeFunctionBody() {
+	open := p.current()
+
+	// Look-ahead may already have lexed tokens past the brace
+	p.tokens = p.tokens[:p.pos+1]
+	p.lexedAll = false
+	p.resetScans()
+	p.lexer.resumeAfter(open)
+
+	if p.lexer.skipBlock(isFileScopeRelevant) {
+		// Drop the brace too: parsing resumes after the closing brace
+		p.tokens = p.tokens[:p.pos]
+		return
+	}
+	p.enterBlock()
+	p.advance()
+}
+
+// isFileScopeRelevant reports whether a token inside a free function
+// body can change what the parser extracts from the file
+func isFileScopeRelevant(kind Kind) bool {
+	return kind == KwNew || kind == KwDelete || kind == KwClass || kind == KwStruct
+}
+
 func (p *Parser) parseClass() *Class {
 	// Get class name
 	if !p.check(TokenIdent) {
 		return nil
 	}
 
-	className := p.current().Value
-	startLine := p.current().Line
+	className := p.text(p.current())
+	startLine := p.line()
 	p.advance()
 
 	// Skip inheritance declaration
-	for !p.isAtEnd() && !p.checkValue("{") && !p.checkValue(";") {
+	for !p.isAtEnd() && !p.checkKind(PunctLBrace) && !p.checkKind(PunctSemi) {
 		p.advance()
 	}
 
 	// Forward declaration (ends with ;)
-	if p.checkValue(";") {
+	if p.checkKind(PunctSemi) {
 		return nil
 	}
 
-	if !p.matchValue("{") {
+	if !p.matchKind(PunctLBrace) {
 		return nil
 	}
 
 	class := &Class{
 		Name:      className,
+		Namespace: p.namespace(),
 		File:      p.file,
 		StartLine: startLine,
 		Members:   []Member{},
@@ -212,18 +465,18 @@ func (p *Parser) parseClass() *Class {
 	// Parse class body
 	braceCount := 1
 	for !p.isAtEnd() && braceCount > 0 {
-		if p.checkValue("{") {
+		if kind := p.current().Kind; kind == PunctLBrace {
 			braceCount++
 			p.advance()
-		} else if p.checkValue("}") {
+		} else if kind == PunctRBrace {
 			braceCount--
 			if braceCount == 0 {
-				class.EndLine = p.current().Line
+				class.EndLine = p.line()
 			}
 			p.advance()
-		} else if p.checkKeyword("public") || p.checkKeyword("private") || p.checkKeyword("protected") {
+		} else if kind == KwPublic || kind == KwPrivate || kind == KwProtected {
 			p.advance()
-			p.matchValue(":") // skip the colon
+			p.matchKind(PunctColon) // skip the colon
 		} else if p.isDestructorStart(className) {
 			if fn := p.parseDestructor(className); fn != nil {
 				class.Destructor = fn
@@ -232,11 +485,11 @@ func (p *Parser) parseClass() *Class {
 			if fn := p.parseConstructor(className); fn != nil {
 				class.Constructor = fn
 			}
-		} else if p.isMemberDeclaration() {
+		} else if decl := p.classifyDeclaration(); decl == declMember {
 			if member := p.parseMember(); member != nil {
 				class.Members = append(class.Members, *member)
 			}
-		} else if p.isFunctionStart() {
+		} else if decl == declFunction {
 			if fn := p.parseMethod(); fn != nil {
 				class.Methods = append(class.Methods, *fn)
 			}
@@ -249,15 +502,15 @@ func (p *Parser) parseClass() *Class {
 }
 
 func (p *Parser) isDestructorStart(className string) bool {
-	if p.checkValue("~") {
+	if p.checkKind(OpTilde) {
 		// Look ahead for class name
-		if p.pos+1 < len(p.tokens) && p.tokens[p.pos+1].Value == className {
+		if p.textIs(p.peekAt(1), className) {
 			return true
 		}
 	}
 	// virtual ~ClassName
-	if p.checkKeyword("virtual") {
-		if p.pos+1 < len(p.tokens) && p.tokens[p.pos+1].Value == "~" {
+	if p.checkKind(KwVirtual) {
+		if p.peekAt(1).Kind == OpTilde {
 			return true
 		}
 	}
@@ -265,9 +518,9 @@ func (p *Parser) isDestructorStart(className string) bool {
 }
 
 func (p *Parser) isConstructorStart(className string) bool {
-	if p.check(TokenIdent) && p.current().Value == className {
+	if p.check(TokenIdent) && p.textIs(p.current(), className) {
 		// Look ahead for (
-		if p.pos+1 < len(p.tokens) && p.tokens[p.pos+1].Value == "(" {
+		if p.peekAt(1).Kind == PunctLParen {
 			return true
 		}
 	}
@@ -275,27 +528,27 @@ func (p *Parser) isConstructorStart(className string) bool {
 }
 
 func (p *Parser) parseDestructor(className string) *Function {
-	startLine := p.current().Line
+	startLine := p.line()
 
 	// Skip virtual if present
-	if p.checkKeyword("virtual") {
+	if p.checkKind(KwVirtual) {
 		p.advance()
 	}
 
 	// Skip ~
-	p.matchValue("~")
+	p.matchKind(OpTilde)
 
 	// Skip class name
 	p.advance()
 
 	// Skip parameters ()
-	if !p.matchValue("(") {
+	if !p.matchKind(PunctLParen) {
 		return nil
 	}
-	for !p.isAtEnd() && !p.checkValue(")") {
+	for !p.isAtEnd() && !p.checkKind(PunctRParen) {
 		p.advance()
 	}
-	p.matchValue(")")
+	p.matchKind(PunctRParen)
 
 	fn := &Function{
 		Name:         "~" + className,
@@ -304,12 +557,12 @@ func (p *Parser) parseDestructor(className string) *Function {
 	}
 
 	// Parse body or skip declaration
-	if p.checkValue(";") {
+	if p.checkKind(PunctSemi) {
 		p.advance()
 		return fn
 	}
 
-	if p.checkValue("{") {
+	if p.checkKind(PunctLBrace) {
 		p.parseFunctionBody(fn)
 	}
 
@@ -317,19 +570,19 @@ func (p *Parser) parseDestructor(className string) *Function {
 }
 
 func (p *Parser) parseConstructor(className string) *Function {
-	startLine := p.current().Line
+	startLine := p.line()
 
 	// Skip class name
 	p.advance()
 
 	// Parse parameters
-	if !p.matchValue("(") {
+	if !p.matchKind(PunctLParen) {
 		return nil
 	}
-	for !p.isAtEnd() && !p.checkValue(")") {
+	for !p.isAtEnd() && !p.checkKind(PunctRParen) {
 		p.advance()
 	}
-	p.matchValue(")")
+	p.matchKind(PunctRParen)
 
 	fn := &Function{
 		Name:      className,
@@ -337,20 +590,20 @@ func (p *Parser) parseConstructor(className string) *Function {
 	}
 
 	// Skip initializer list
-	if p.checkValue(":") {
+	if p.checkKind(PunctColon) {
 		p.advance()
-		for !p.isAtEnd() && !p.checkValue("{") && !p.checkValue(";") {
+		for !p.isAtEnd() && !p.checkKind(PunctLBrace) && !p.checkKind(PunctSemi) {
 			p.advance()
 		}
 	}
 
 	// Parse body or skip declaration
-	if p.checkValue(";") {
+	if p.checkKind(PunctSemi) {
 		p.advance()
 		return fn
 	}
 
-	if p.checkValue("{") {
+	if p.checkKind(PunctLBrace) {
 		p.parseFunctionBody(fn)
 	}
 
@@ -358,14 +611,14 @@ func (p *Parser) parseConstructor(className string) *Function {
 }
 
 func (p *Parser) parseMethod() *Function {
-	startLine := p.current().Line
+	startLine := p.line()
 
 	// Skip return type and modifiers
-	for !p.isAtEnd() && !p.checkValue("(") && !p.checkValue(";") && !p.checkValue("{") {
+	for !p.isAtEnd() && !p.checkKind(PunctLParen) && !p.checkKind(PunctSemi) && !p.checkKind(PunctLBrace) {
 		p.advance()
 	}
 
-	if p.checkValue(";") {
+	if p.checkKind(PunctSemi) {
 		p.advance()
 		return nil
 	}
@@ -373,19 +626,19 @@ func (p *Parser) parseMethod() *Function {
 	// Get function name (token before '(')
 	funcName := ""
 	if p.pos > 0 {
-		funcName = p.tokens[p.pos-1].Value
+		funcName = p.text(p.tokens[p.pos-1])
 	}
 
-	if !p.matchValue("(") {
+	if !p.matchKind(PunctLParen) {
 		return nil
 	}
 
 	// Skip parameters
 	parenCount := 1
 	for !p.isAtEnd() && parenCount > 0 {
-		if p.checkValue("(") {
+		if p.checkKind(PunctLParen) {
 			parenCount++
-		} else if p.checkValue(")") {
+		} else if p.checkKind(PunctRParen) {
 			parenCount--
 		}
 		p.advance()
@@ -397,19 +650,19 @@ func (p *Parser) parseMethod() *Function {
 	}
 
 	// Skip const, noexcept, etc.
-	for p.checkKeyword("const") || p.check(TokenIdent) {
-		if p.checkValue("{") || p.checkValue(";") {
+	for p.checkKind(KwConst) || p.check(TokenIdent) {
+		if p.checkKind(PunctLBrace) || p.checkKind(PunctSemi) {
 			break
 		}
 		p.advance()
 	}
 
-	if p.checkValue(";") {
+	if p.checkKind(PunctSemi) {
 		p.advance()
 		return fn
 	}
 
-	if p.checkValue("{") {
+	if p.checkKind(PunctLBrace) {
 		p.parseFunctionBody(fn)
 	}
 
@@ -417,43 +670,40 @@ func (p *Parser) parseMethod() *Function {
 }
 
 func (p *Parser) parseFunctionBody(fn *Function) {
-	if !p.matchValue("{") {
+	if !p.matchKind(PunctLBrace) {
 		return
 	}
 
 	braceCount := 1
 	for !p.isAtEnd() && braceCount > 0 {
-		if p.checkValue("{") {
+		if kind := p.current().Kind; kind == PunctLBrace {
 			braceCount++
 			p.advance()
-		} else if p.checkValue("}") {
+		} else if kind == PunctRBrace {
 			braceCount--
 			if braceCount == 0 {
-				fn.EndLine = p.current().Line
+				fn.EndLine = p.line()
 			}
 			p.advance()
-		} else if p.checkKeyword("new") {
+		} else if kind == KwNew {
 			alloc := p.parseAllocation()
 			if alloc != nil {
 				fn.Allocations = append(fn.Allocations, *alloc)
 			}
-		} else if p.checkKeyword("delete") {
+		} else if kind == KwDelete {
 			dealloc := p.parseDeallocation()
 			if dealloc != nil {
 				fn.Deallocations = append(fn.Deallocations, *dealloc)
 			}
 		} else if p.check(TokenIdent) {
-			identName := p.current().Value
-			identLine := p.current().Line
-
 			// Check for method calls
-			if p.pos+1 < len(p.tokens) && p.tokens[p.pos+1].Value == "(" {
-				fn.MethodCalls = append(fn.MethodCalls, identName)
+			if p.peekAt(1).Kind == PunctLParen {
+				fn.MethodCalls = append(fn.MethodCalls, p.text(p.current()))
 			}
 
 			// Check for pointer aliasing: ptr2 = ptr1 (where both are identifiers, no 'new')
 			// Pattern: ident = ident ; (without 'new' keyword in between)
-			if alias := p.checkPointerAlias(identName, identLine); alias != nil {
+			if alias := p.checkPointerAlias(p.current()); alias != nil {
 				fn.Aliases = append(fn.Aliases, *alias)
 			}
 
@@ -466,36 +716,25 @@ func (p *Parser) parseFunctionBody(fn *Function) {
 
 // checkPointerAlias checks if current position is a pointer alias assignment
 // Pattern: target = source; (where source is an identifier, not 'new')
-func (p *Parser) checkPointerAlias(targetName string, line int) *PointerAlias {
-	// Look ahead: ident = ident ;
-	if p.pos+3 >= len(p.tokens) {
-		return nil
-	}
-
+func (p *Parser) checkPointerAlias(target Token) *PointerAlias {
 	// Check pattern: current(ident) = next(ident) ; (or other terminator)
-	if p.tokens[p.pos+1].Value != "=" {
+	if p.peekAt(1).Kind != OpAssign {
 		return nil
 	}
 
-	nextTok := p.tokens[p.pos+2]
+	// An identifier is never 'new', which is lexed as a keyword
+	nextTok := p.peekAt(2)
 	if nextTok.Type != TokenIdent {
 		return nil
 	}
 
-	// Make sure it's not: ident = new ...
-	if nextTok.Value == "new" {
-		return nil
-	}
-
 	// Check it ends with ; or is followed by something reasonable
-	if p.pos+3 < len(p.tokens) {
-		afterSource := p.tokens[p.pos+3]
-		if afterSource.Value == ";" || afterSource.Value == "}" || afterSource.Value == "," {
-			return &PointerAlias{
-				TargetVar: targetName,
-				SourceVar: nextTok.Value,
-				Line:      line,
-			}
+	afterSource := p.peekAt(3)
+	if afterSource.Kind == PunctSemi || afterSource.Kind == PunctRBrace || afterSource.Kind == PunctComma {
+		return &PointerAlias{
+			TargetVar: p.text(target),
+			SourceVar: p.text(nextTok),
+			Line:      int(target.Line),
 		}
 	}
 
@@ -503,11 +742,11 @@ func (p *Parser) checkPointerAlias(targetName string, line int) *PointerAlias {
 }
 
 func (p *Parser) parseAllocation() *Allocation {
-	line := p.current().Line
+	line := p.line()
 	p.advance() // skip 'new'
 
 	isArray := false
-	if p.checkValue("[") {
+	if p.checkKind(PunctLBracket) {
 		isArray = true
 	}
 
@@ -521,8 +760,8 @@ func (p *Parser) parseAllocation() *Allocation {
 	}
 
 	// Skip to end of statement
-	for !p.isAtEnd() && !p.checkValue(";") && !p.checkValue("{") {
-		if p.checkValue("[") {
+	for !p.isAtEnd() && !p.checkKind(PunctSemi) && !p.checkKind(PunctLBrace) {
+		if p.checkKind(PunctLBracket) {
 			isArray = true
 		}
 		p.advance()
@@ -538,11 +777,12 @@ func (p *Parser) parseAllocation() *Allocation {
 func (p *Parser) findAssignmentTarget() string {
 	// Look backwards for pattern: varName = or this->varName =
 	for i := p.pos - 1; i >= 0 && i > p.pos-10; i-- {
-		if p.tokens[i].Value == "=" {
+		if p.tokens[i].Kind == OpAssign {
 			// Found assignment, look for variable before it
 			for j := i - 1; j >= 0 && j > i-5; j-- {
-				if p.tokens[j].Type == TokenIdent && p.tokens[j].Value != "this" {
-					return p.tokens[j].Value
+				// 'this' is a keyword, so it is never picked up here
+				if p.tokens[j].Type == TokenIdent {
+					return p.text(p.tokens[j])
 				}
 			}
 		}
@@ -551,30 +791,30 @@ func (p *Parser) findAssignmentTarget() string {
 }
 
 func (p *Parser) parseDeallocation() *Deallocation {
-	line := p.current().Line
+	line := p.line()
 	p.advance() // skip 'delete'
 
 	isArray := false
-	if p.checkValue("[") {
+	if p.checkKind(PunctLBracket) {
 		isArray = true
-		p.advance()       // skip [
-		p.matchValue("]") // skip ]
+		p.advance()                // skip [
+		p.matchKind(PunctRBracket) // skip ]
 	}
 
 	// Get the variable being deleted
 	varName := ""
 
 	// Check for this-> prefix (this is a KEYWORD, not ident)
-	if p.checkKeyword("this") {
+	if p.checkKind(KwThis) {
 		p.advance() // skip 'this'
-		if p.checkValue("->") {
+		if p.checkKind(OpArrow) {
 			p.advance() // skip '->'
 			if p.check(TokenIdent) {
-				varName = p.current().Value
+				varName = p.text(p.current())
 			}
 		}
 	} else if p.check(TokenIdent) {
-		varName = p.current().Value
+		varName = p.text(p.current())
 	}
 
 	if varName == "" {
@@ -588,42 +828,62 @@ func (p *Parser) parseDeallocation() *Deallocation {
 	}
 }
 
-func (p *Parser) isMemberDeclaration() bool {
-	// Look for pattern: Type* varName; or Type *varName;
-	// Must contain a pointer indicator
-	savedPos := p.pos
-	hasPointer := false
-	hasIdent := false
+// Declaration kinds returned by classifyDeclaration
+const (
+	declOther = iota
+	declMember
+	declFunction
+)
 
-	for i := 0; i < 10 && savedPos+i < len(p.tokens); i++ {
-		tok := p.tokens[savedPos+i]
-		if tok.Value == ";" {
-			break
-		}
-		if tok.Value == "(" || tok.Value == "{" {
-			return false // It's a function
-		}
-		if tok.Value == "*" {
-			hasPointer = true
-		}
-		if tok.Type == TokenIdent {
-			hasIdent = true
+// classifyDeclaration classifies the class body statement starting at the
+// current token as a pointer member (Type* varName; within 10 tokens), a
+// function (a ( within 15 tokens, before any ;, { or }), or neither. The
+// stops it searches for are cached, so when the body loop advances one
+// token at a time each token is scanned a bounded number of times.
+func (p *Parser) classifyDeclaration() int {
+	// Pointer member: a * and an identifier before the first ; within 10
+	// tokens, and no ( or { before it
+	declEnd := p.nextStop(&p.declScan, p.pos, isDeclStop)
+	if declEnd-p.pos >= 10 || p.at(declEnd).Kind == PunctSemi || p.at(declEnd).Type == TokenEOF {
+		window := min(declEnd, p.pos+10)
+		if p.nextStop(&p.starScan, p.pos, isStarOrDeclStop) < window &&
+			p.nextStop(&p.identScan, p.pos, isIdentOrDeclStop) < window {
+			return declMember
 		}
 	}
 
-	return hasPointer && hasIdent
+	if i := p.nextStop(&p.callScan, p.pos, isCallStop); i-p.pos < 15 && p.at(i).Kind == PunctLParen {
+		return declFunction
+	}
+	return declOther
+}
+
+func isDeclStop(tok Token) bool {
+	return tok.Kind == PunctSemi || tok.Kind == PunctLParen || tok.Kind == PunctLBrace
+}
+
+func isStarOrDeclStop(tok Token) bool {
+	return tok.Kind == OpStar || isDeclStop(tok)
+}
+
+func isIdentOrDeclStop(tok Token) bool {
+	return tok.Type == TokenIdent || isDeclStop(tok)
+}
+
+func isCallStop(tok Token) bool {
+	return tok.Kind == PunctLParen || tok.Kind == PunctSemi || tok.Kind == PunctLBrace || tok.Kind == PunctRBrace
 }
 
 func (p *Parser) parseMember() *Member {
-	startLine := p.current().Line
-	var tokens []Token
+	startLine := p.line()
+	start := p.pos
 
 	// Collect tokens until semicolon
-	for !p.isAtEnd() && !p.checkValue(";") {
-		tokens = append(tokens, p.current())
+	for !p.isAtEnd() && !p.checkKind(PunctSemi) {
 		p.advance()
 	}
-	p.matchValue(";")
+	tokens := p.tokens[start:p.pos]
+	p.matchKind(PunctSemi)
 
 	if len(tokens) < 2 {
 		return nil
@@ -636,16 +896,16 @@ func (p *Parser) parseMember() *Member {
 	var typeTokens []string
 
 	for i, tok := range tokens {
-		if tok.Value == "*" {
+		if tok.Kind == OpStar {
 			isPointer = true
-		} else if tok.Value == "[" {
+		} else if tok.Kind == PunctLBracket {
 			isArray = true
 		} else if tok.Type == TokenIdent {
 			// Last identifier before ; is the variable name
-			if i == len(tokens)-1 || tokens[i+1].Value == "[" || tokens[i+1].Value == "=" {
-				varName = tok.Value
+			if i == len(tokens)-1 || tokens[i+1].Kind == PunctLBracket || tokens[i+1].Kind == OpAssign {
+				varName = p.text(tok)
 			} else {
-				typeTokens = append(typeTokens, tok.Value)
+				typeTokens = append(typeTokens, p.text(tok))
 			}
 		}
 	}
@@ -663,66 +923,83 @@ func (p *Parser) parseMember() *Member {
 	}
 }
 
-func (p *Parser) isFunctionStart() bool {
-	// Look ahead for pattern: ... name(...)
-	savedPos := p.pos
-	for i := 0; i < 15 && savedPos+i < len(p.tokens); i++ {
-		tok := p.tokens[savedPos+i]
-		if tok.Value == ";" {
-			return false
-		}
-		if tok.Value == "(" {
-			return true
-		}
-		if tok.Value == "{" || tok.Value == "}" {
-			return false
+// Token navigation helpers
+
+// at returns the token at index i, lexing up to it if needed.
+// Past the end of input it returns the EOF token.
+func (p *Parser) at(i int) Token {
+	if i < len(p.tokens) {
+		return p.tokens[i]
+	}
+	return p.lex(i)
+}
+
+// lex lexes tokens up to index i and returns it, or the EOF token
+func (p *Parser) lex(i int) Token {
+	for i >= len(p.tokens) {
+		if p.lexedAll {
+			return p.tokens[len(p.tokens)-1]
 		}
+		tok := p.lexer.Next()
+		p.tokens = append(p.tokens, tok)
+		p.lexedAll = tok.Type == TokenEOF
 	}
-	return false
+	return p.tokens[i]
+}
+
+// peekAt returns the token n positions after the current one
+func (p *Parser) peekAt(n int) Token {
+	return p.at(p.pos + n)
 }
 
-// Token navigation helpers
 func (p *Parser) current() Token {
-	if p.pos < len(p.tokens) {
-		return p.tokens[p.pos]
-	}
-	return Token{Type: TokenEOF}
+	return p.at(p.pos)
 }
 
 func (p *Parser) advance() {
-	if p.pos < len(p.tokens) {
+	if !p.isAtEnd() {
 		p.pos++
 	}
 }
 
 func (p *Parser) isAtEnd() bool {
-	return p.pos >= len(p.tokens) || p.tokens[p.pos].Type == TokenEOF
+	return p.current().Type == TokenEOF
 }
 
 func (p *Parser) check(tokenType TokenType) bool {
-	return !p.isAtEnd() && p.current().Type == tokenType
+	t := p.current().Type
+	return t == tokenType && t != TokenEOF
 }
 
-func (p *Parser) checkValue(value string) bool {
-	return !p.isAtEnd() && p.current().Value == value
+// line returns the source line of the current token
+func (p *Parser) line() int {
+	return int(p.current().Line)
 }
 
-func (p *Parser) checkKeyword(keyword string) bool {
-	return p.check(TokenKeyword) && p.current().Value == keyword
+// checkKind reports whether the current token is the given keyword,
+// operator or punctuation. The EOF token has KindNone, so it never matches.
+func (p *Parser) checkKind(kind Kind) bool {
+	return p.current().Kind == kind
 }
 
-func (p *Parser) matchValue(value string) bool {
-	if p.checkValue(value) {
+func (p *Parser) matchKind(kind Kind) bool {
+	if p.checkKind(kind) {
 		p.advance()
 		return true
 	}
 	return false
 }
 
-func (p *Parser) matchKeyword(keyword string) bool {
-	if p.checkKeyword(keyword) {
-		p.advance()
-		return true
+// text returns the token's text. Identifiers come from the shared symbol
+// table, so each distinct name is stored once per run.
+func (p *Parser) text(tok Token) string {
+	if tok.Type == TokenIdent {
+		return Symbols.InternBytes(p.src[tok.Start : tok.Start+tok.Len])
 	}
-	return false
+	return tok.Text(p.src)
+}
+
+// textIs compares the token's text with s without copying it
+func (p *Parser) textIs(tok Token, s string) bool {
+	return string(p.src[tok.Start:tok.Start+tok.Len]) == s
 }
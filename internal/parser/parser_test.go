@@ -0,0 +1,156 @@
+package parser
+
+import (
+	"os"
+	"path/filepath"
+	"testing"
+
+	"leakcheck/internal/corpus"
+)
+
+const bufferSource = `#include "buffer.h"
+
+namespace app {
+class Buffer {
+  int *data;
+  char *name;
+  int size;
+
+public:
+  Buffer() {
+    data = new int[8];
+    name = new char(1);
+  }
+  ~Buffer() { delete[] data; }
+  void reset() {
+    int *tmp = data;
+    delete tmp;
+  }
+};
+}
+`
+
+func TestParseSource(t *testing.T) {
+	classes := ParseSource("/src/buffer.cpp", []byte(bufferSource))
+	if len(classes) != 1 {
+		t.Fatalf("got %d classes, want 1", len(classes))
+	}
+	c := &classes[0]
+	if c.QualifiedName() != "app::Buffer" {
+		t.Errorf("QualifiedName() = %q, want app::Buffer", c.QualifiedName())
+	}
+	if len(c.Includes) != 1 || c.Includes[0] != "buffer.h" {
+		t.Errorf("Includes = %q, want [buffer.h]", c.Includes)
+	}
+
+	pointers := map[string]bool{}
+	for _, m := range c.Members {
+		pointers[m.Name] = m.IsPointer
+	}
+	if !pointers["data"] || !pointers["name"] || pointers["size"] {
+		t.Errorf("pointer members = %v, want data and name", pointers)
+	}
+
+	if c.Constructor == nil || len(c.Constructor.Allocations) != 2 {
+		t.Fatalf("constructor = %+v, want 2 allocations", c.Constructor)
+	}
+	if a := c.Constructor.Allocations[0]; a.VarName != "data" || !a.IsArray || a.Line != 11 {
+		t.Errorf("first allocation = %+v, want data[] at line 11", a)
+	}
+	if a := c.Constructor.Allocations[1]; a.VarName != "name" || a.IsArray {
+		t.Errorf("second allocation = %+v, want name", a)
+	}
+	if c.Destructor == nil || len(c.Destructor.Deallocations) != 1 {
+		t.Fatalf("destructor = %+v, want 1 deallocation", c.Destructor)
+	}
+	if d := c.Destructor.Deallocations[0]; d.VarName != "data" || !d.IsArray {
+		t.Errorf("deallocation = %+v, want delete[] data", d)
+	}
+	if len(c.Methods) != 1 || len(c.Methods[0].Aliases) != 1 {
+		t.Fatalf("methods = %+v, want reset with one alias", c.Methods)
+	}
+	if a := c.Methods[0].Aliases[0]; a.SourceVar != "data" || a.TargetVar != "tmp" {
+		t.Errorf("alias = %+v, want tmp = data", a)
+	}
+}
+
+func TestSetFile(t *testing.T) {
+	c := ParseSource("/src/buffer.cpp", []byte(bufferSource))[0]
+	files := []string{c.File, c.Members[0].File, c.Constructor.File, c.Constructor.Allocations[0].File,
+		c.Destructor.Deallocations[0].File, c.Methods[0].Aliases[0].File}
+	for i, file := range files {
+		if file != "/src/buffer.cpp" {
+			t.Errorf("file %d = %q, want /src/buffer.cpp", i, file)
+		}
+	}
+}
+
+// loadCorpus generates a small corpus and returns its files and contents
+func loadCorpus(tb testing.TB) ([]string, [][]byte) {
+	tb.Helper()
+	dir := tb.TempDir()
+	opts := corpus.DefaultOptions()
+	opts.Classes = 200
+	if _, err := corpus.Generate(dir, opts); err != nil {
+		tb.Fatal(err)
+	}
+	var files []string
+	var contents [][]byte
+	err := filepath.WalkDir(dir, func(path string, d os.DirEntry, err error) error {
+		if err != nil || d.IsDir() {
+			return err
+		}
+		content, err := os.ReadFile(path)
+		files = append(files, path)
+		contents = append(contents, content)
+		return err
+	})
+	if err != nil {
+		tb.Fatal(err)
+	}
+	return files, contents
+}
+
+func totalBytes(contents [][]byte) int64 {
+	var n int64
+	for _, c := range contents {
+		n += int64(len(c))
+	}
+	return n
+}
+
+func BenchmarkTokenize(b *testing.B) {
+	_, contents := loadCorpus(b)
+	b.SetBytes(totalBytes(contents))
+	b.ReportAllocs()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		for _, c := range contents {
+			NewLexer(c).Tokenize()
+		}
+	}
+}
+
+func BenchmarkParseSource(b *testing.B) {
+	files, contents := loadCorpus(b)
+	b.SetBytes(totalBytes(contents))
+	b.ReportAllocs()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		for i, c := range contents {
+			ParseSource(files[i], c)
+		}
+	}
+}
+
+func BenchmarkPrescan(b *testing.B) {
+	_, contents := loadCorpus(b)
+	b.SetBytes(totalBytes(contents))
+	b.ReportAllocs()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		for _, c := range contents {
+			Prescan(c)
+		}
+	}
+}
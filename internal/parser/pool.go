@@ -0,0 +1,40 @@
+package parser
+
+import "sync"
+
+// bytesPerToken is the average source bytes per token in typical C++,
+// including whitespace and comments. It is used to pre-size token buffers.
+const bytesPerToken = 6
+
+// maxPooledTokens bounds the buffers kept in tokenPool, so one huge file
+// does not pin its token buffer for the rest of the run
+const maxPooledTokens = 1 << 20
+
+// tokenPool recycles token buffers across files. Parallel parse workers
+// each take a buffer for the duration of one file.
+var tokenPool sync.Pool
+
+// estimateTokens estimates the number of tokens in n bytes of source
+func estimateTokens(n int) int {
+	return n/bytesPerToken + 1
+}
+
+// getTokenBuffer returns an empty token buffer with room for about
+// the number of tokens expected in n bytes of source
+func getTokenBuffer(n int) []Token {
+	want := estimateTokens(n)
+	if v, ok := tokenPool.Get().(*[]Token); ok && cap(*v) >= want {
+		return (*v)[:0]
+	}
+	return make([]Token, 0, want)
+}
+
+// putTokenBuffer returns a token buffer to the pool.
+// The caller must not use the buffer afterwards.
+func putTokenBuffer(buf []Token) {
+	if cap(buf) > maxPooledTokens {
+		return
+	}
+	buf = buf[:0]
+	tokenPool.Put(&buf)
+}
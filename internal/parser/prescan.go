@@ -0,0 +1,130 @@
+package parser
+
+import "bytes"
+
+// Prescan is a byte-level pass that runs before lexing. It reports whether
+// the content contains the word new or delete; a file that does not can
+// only contribute to a finding through a class it shares with a file that
+// does. For such files it also returns the names of the classes the parser
+// could extract from them: every identifier after class or struct, and the
+// last identifier before each ::. The names are a superset of what
+// ParseSource would return, and may include words in comments and strings.
+func Prescan(content []byte) (relevant bool, classNames []string) {
+	if containsWord(content, "new") || containsWord(content, "delete") {
+		return true, nil
+	}
+
+	seen := make(map[string]bool)
+	add := func(name []byte) {
+		if len(name) > 0 && !seen[string(name)] {
+			seen[string(name)] = true
+			classNames = append(classNames, string(name))
+		}
+	}
+	for _, keyword := range []string{"class", "struct"} {
+		for i := 0; ; {
+			at := indexWord(content, keyword, i)
+			if at < 0 {
+				break
+			}
+			i = at + len(keyword)
+			add(identifierAt(content, skipSpaceAndComments(content, i)))
+		}
+	}
+	for i := 0; ; {
+		at := bytes.Index(content[i:], []byte("::"))
+		if at < 0 {
+			break
+		}
+		add(identifierBefore(content, i+at))
+		i += at + 2
+	}
+	return false, classNames
+}
+
+// containsWord reports whether word occurs in content as a whole identifier
+func containsWord(content []byte, word string) bool {
+	return indexWord(content, word, 0) >= 0
+}
+
+// indexWord returns the offset of the first whole-identifier occurrence of
+// word at or after from, or -1
+func indexWord(content []byte, word string, from int) int {
+	for from < len(content) {
+		at := bytes.Index(content[from:], []byte(word))
+		if at < 0 {
+			return -1
+		}
+		start := from + at
+		end := start + len(word)
+		if (start == 0 || byteClass[content[start-1]]&classIdent == 0) &&
+			(end == len(content) || byteClass[content[end]]&classIdent == 0) {
+			return start
+		}
+		from = end
+	}
+	return -1
+}
+
+// skipSpaceAndComments returns the offset of the first byte at or after i
+// that is not whitespace or part of a comment
+func skipSpaceAndComments(content []byte, i int) int {
+	for i < len(content) {
+		switch {
+		case byteClass[content[i]]&classSpace != 0:
+			i++
+		case bytes.HasPrefix(content[i:], []byte("//")):
+			end := bytes.IndexByte(content[i:], '\n')
+			if end < 0 {
+				return len(content)
+			}
+			i += end
+		case bytes.HasPrefix(content[i:], []byte("/*")):
+			end := bytes.Index(content[i+2:], []byte("*/"))
+			if end < 0 {
+				return len(content)
+			}
+			i += 2 + end + 2
+		default:
+			return i
+		}
+	}
+	return i
+}
+
+// identifierAt returns the identifier starting at i, or nil
+func identifierAt(content []byte, i int) []byte {
+	if i >= len(content) || byteClass[content[i]]&classIdentStart == 0 {
+		return nil
+	}
+	end := i + 1
+	for end < len(content) && byteClass[content[end]]&classIdent != 0 {
+		end++
+	}
+	return content[i:end]
+}
+
+// identifierBefore returns the last identifier before offset end that is
+// not a keyword, looking back no further than the start of the statement
+func identifierBefore(content []byte, end int) []byte {
+	i := end
+	for i > 0 {
+		ch := content[i-1]
+		if ch == ';' || ch == '{' || ch == '}' {
+			return nil
+		}
+		if byteClass[ch]&classIdent == 0 {
+			i--
+			continue
+		}
+		wordEnd := i
+		for i > 0 && byteClass[content[i-1]]&classIdent != 0 {
+			i--
+		}
+		word := content[i:wordEnd]
+		if _, isKeyword := keywords[string(word)]; !isKeyword && byteClass[word[0]]&classIdentStart != 0 {
+			return word
+		}
+	}
+	return nil
+}
@@ -0,0 +1,30 @@
+package parser
+
+import (
+	"slices"
+	"testing"
+)
+
+func TestPrescan(t *testing.T) {
+	for _, tc := range []struct {
+		name     string
+		src      string
+		relevant bool
+		names    []string
+	}{
+		{"new", "void f() { int *p = new int; }", true, nil},
+		{"delete", "Foo::~Foo() { delete p; }", true, nil},
+		{"words containing new", "int renew, newest; // anew", false, nil},
+		{"class and struct", "class Foo {}; struct Bar;", false, []string{"Foo", "Bar"}},
+		{"comment before the name", "class /* exported */ Foo {};", false, []string{"Foo"}},
+		{"qualified definitions", "void Foo::reset() {}\nns::Bar::Bar() {}", false, []string{"Foo", "ns", "Bar"}},
+		{"keyword before ::", "int f() { return ::y; }", false, nil},
+	} {
+		t.Run(tc.name, func(t *testing.T) {
+			relevant, names := Prescan([]byte(tc.src))
+			if relevant != tc.relevant || !slices.Equal(names, tc.names) {
+				t.Errorf("Prescan = %v, %q; want %v, %q", relevant, names, tc.relevant, tc.names)
+			}
+		})
+	}
+}
@@ -2,63 +2,214 @@ package parser
 
 import (
 	"path/filepath"
+	"slices"
 	"strings"
 )
 
-// ClassRegistry holds all parsed classes for cross-file analysis
+// ClassRegistry holds all parsed classes for cross-file analysis.
+// Classes with the same name are merged in place as files are added, so the
+// registry can be fed while parsing is still running. It is not safe for
+// concurrent use: feed it from one goroutine, in a deterministic file order,
+// since the merge prefers earlier definitions.
 type ClassRegistry struct {
-	// Classes by name (for matching header declarations with cpp implementations)
-	classesByName map[string][]*Class
-	// All classes
-	allClasses []Class
+	// Index into entries by qualified class name (for matching header
+	// declarations with cpp implementations)
+	byKey map[classKey]int
+	// Entries by unqualified name, for definitions that do not name the
+	// namespace of their class
+	byName map[string][]int
+	// Merged classes, in order of first occurrence; nil for entries merged
+	// into an earlier one by resolve
+	entries []*classEntry
+	removed int
+}
+
+// classEntry is one merged class and the files it was assembled from
+type classEntry struct {
+	class Class
+	// files lists every distinct source file, the first occurrence first
+	files []string
+	// methods maps a method name to its last index in class.Methods;
+	// built on the first merge
+	methods map[string]int
 }
 
 // NewClassRegistry creates a new registry
 func NewClassRegistry() *ClassRegistry {
 	return &ClassRegistry{
-		classesByName: make(map[string][]*Class),
+		byKey:  make(map[classKey]int),
+		byName: make(map[string][]int),
 	}
 }
 
-// AddClasses adds parsed classes to the registry
+// classKey identifies a class by its qualified name
+type classKey struct {
+	namespace, name string
+}
+
+func keyOf(c *Class) classKey {
+	return classKey{c.Namespace, c.Name}
+}
+
+// AddClasses adds parsed classes to the registry, merging each one into an
+// earlier class of the same qualified name if there is one
 func (r *ClassRegistry) AddClasses(classes []Class) {
 	for i := range classes {
 		class := &classes[i]
-		r.allClasses = append(r.allClasses, *class)
-		r.classesByName[class.Name] = append(r.classesByName[class.Name], class)
+		if idx, exists := r.find(class); exists {
+			entry := r.entries[idx]
+			if entry.class.Namespace == "" && class.Namespace != "" {
+				// The namespace is known now
+				delete(r.byKey, keyOf(&entry.class))
+				entry.class.Namespace = class.Namespace
+				r.byKey[keyOf(&entry.class)] = idx
+			}
+			entry.merge(class)
+			continue
+		}
+		idx := len(r.entries)
+		r.byKey[keyOf(class)] = idx
+		r.byName[class.Name] = append(r.byName[class.Name], idx)
+		r.entries = append(r.entries, &classEntry{class: *class, files: []string{class.File}})
 	}
 }
 
-// MergeClasses merges class definitions split across header and implementation files
-// Returns a list of fully merged classes
-func (r *ClassRegistry) MergeClasses() []Class {
-	merged := make(map[string]*Class)
+// find returns the entry class merges into: the entry of the same
+// qualified name, else a same-named entry that lacks one side's namespace.
+// An entry without a namespace (a definition relying on a using-directive)
+// takes the first class with one. A class without one joins a class with
+// a namespace only if their files include one another; otherwise it waits
+// for MergeClasses, since the class it belongs to may not be scanned yet.
+func (r *ClassRegistry) find(class *Class) (int, bool) {
+	if idx, ok := r.byKey[keyOf(class)]; ok {
+		return idx, true
+	}
+	for _, idx := range r.byName[class.Name] {
+		entry := r.entries[idx]
+		switch {
+		case entry == nil:
+		case class.Namespace != "" && entry.class.Namespace == "":
+			return idx, true
+		case class.Namespace == "" && entry.related(class):
+			return idx, true
+		}
+	}
+	return -1, false
+}
 
-	for _, class := range r.allClasses {
-		existing, exists := merged[class.Name]
-		if !exists {
-			// First occurrence of this class
-			classCopy := class
-			merged[class.Name] = &classCopy
+// resolve merges every entry still without a namespace into a same-named
+// entry with one: one whose files it includes or is included by, else the
+// first. The merged entry keeps the earlier position.
+func (r *ClassRegistry) resolve() {
+	for idx, entry := range r.entries {
+		if entry == nil || entry.class.Namespace != "" || len(r.byName[entry.class.Name]) < 2 {
+			continue
+		}
+		target := -1
+		for _, other := range r.byName[entry.class.Name] {
+			candidate := r.entries[other]
+			if candidate == nil || candidate.class.Namespace == "" {
+				continue
+			}
+			if target < 0 {
+				target = other
+			}
+			if candidate.related(&entry.class) {
+				target = other
+				break
+			}
+		}
+		if target < 0 {
 			continue
 		}
 
-		// Merge: combine information from multiple files
-		r.mergeClassInto(existing, &class)
+		first, second := min(idx, target), max(idx, target)
+		merged, gone := r.entries[first], r.entries[second]
+		delete(r.byKey, keyOf(&merged.class))
+		delete(r.byKey, keyOf(&gone.class))
+		merged.absorb(gone)
+		r.byKey[keyOf(&merged.class)] = first
+		r.entries[second] = nil
+		r.removed++
+	}
+}
+
+// absorb merges every class other was assembled from into the entry
+func (e *classEntry) absorb(other *classEntry) {
+	if e.class.Namespace == "" {
+		e.class.Namespace = other.class.Namespace
+	}
+	e.merge(&other.class)
+	for _, file := range other.files[1:] {
+		if !slices.Contains(e.files, file) {
+			e.files = append(e.files, file)
+		}
+	}
+}
+
+// related reports whether class comes from a file that includes one of
+// the entry's files, or is included by its first one
+func (e *classEntry) related(class *Class) bool {
+	for _, file := range e.files {
+		if includesFile(class.Includes, file) {
+			return true
+		}
+	}
+	return includesFile(e.class.Includes, class.File)
+}
+
+// includesFile reports whether one of the #include targets names file.
+// Targets are resolved by path suffix, since include directories are
+// not known.
+func includesFile(includes []string, file string) bool {
+	if len(includes) == 0 {
+		return false
+	}
+	file = filepath.ToSlash(file)
+	for _, target := range includes {
+		for strings.HasPrefix(target, "./") || strings.HasPrefix(target, "../") {
+			target = target[strings.IndexByte(target, '/')+1:]
+		}
+		if strings.HasSuffix(file, target) && (len(file) == len(target) || file[len(file)-len(target)-1] == '/') {
+			return true
+		}
 	}
+	return false
+}
 
-	// Convert map to slice
-	result := make([]Class, 0, len(merged))
-	for _, class := range merged {
-		result = append(result, *class)
+// Len returns the number of distinct classes registered so far
+func (r *ClassRegistry) Len() int {
+	return len(r.entries) - r.removed
+}
+
+// MergeClasses returns the merged classes, ordered by first occurrence,
+// after merging the classes still without a namespace (see resolve).
+// The File of a class found in several files lists the first file's path
+// followed by the base names of the others; Files holds their full paths.
+func (r *ClassRegistry) MergeClasses() []Class {
+	r.resolve()
+	result := make([]Class, 0, r.Len())
+	for _, entry := range r.entries {
+		if entry == nil {
+			continue
+		}
+		class := entry.class
+		class.File = displayFiles(entry.files)
+		if len(entry.files) > 1 {
+			class.Files = entry.files
+		}
+		result = append(result, class)
 	}
 	return result
 }
 
-// mergeClassInto merges source class info into target
-func (r *ClassRegistry) mergeClassInto(target, source *Class) {
-	// Track which file is header vs implementation
-	targetIsHeader := isHeaderFile(target.File)
+// merge merges source class info into the entry
+func (e *classEntry) merge(source *Class) {
+	target := &e.class
+
+	// Track which file is header vs implementation; a class already merged
+	// from several files counts as the kind of the last one added
+	targetIsHeader := isHeaderFile(e.files[len(e.files)-1])
 	sourceIsHeader := isHeaderFile(source.File)
 
 	// Merge members - always prefer header over implementation
@@ -95,25 +246,58 @@ func (r *ClassRegistry) mergeClassInto(target, source *Class) {
 		}
 	}
 
-	// Merge methods
-	methodMap := make(map[string]*Function)
-	for i := range target.Methods {
-		methodMap[target.Methods[i].Name] = &target.Methods[i]
+	// Merge methods. Methods appended here only become visible to lookups
+	// from the next merge on, so repeated names within one source are all kept.
+	if e.methods == nil {
+		// The first merge copies the methods, so updates never write
+		// through to the caller's slice
+		target.Methods = append(make([]Function, 0, len(target.Methods)+len(source.Methods)), target.Methods...)
+		e.methods = make(map[string]int, len(target.Methods)+len(source.Methods))
+		for i := range target.Methods {
+			e.methods[target.Methods[i].Name] = i
+		}
 	}
-	for _, method := range source.Methods {
-		existing, exists := methodMap[method.Name]
+	added := len(target.Methods)
+	for i := range source.Methods {
+		method := &source.Methods[i]
+		idx, exists := e.methods[method.Name]
 		if !exists {
-			target.Methods = append(target.Methods, method)
+			target.Methods = append(target.Methods, *method)
 		} else if len(method.Allocations) > 0 || len(method.Deallocations) > 0 {
 			// Source has more info, update
-			*existing = method
+			target.Methods[idx] = *method
+		}
+	}
+	for i := added; i < len(target.Methods); i++ {
+		e.methods[target.Methods[i].Name] = i
+	}
+
+	// Record the file
+	for _, file := range e.files {
+		if file == source.File {
+			return
 		}
 	}
+	e.files = append(e.files, source.File)
+}
 
-	// Update file reference to include both
-	if !strings.Contains(target.File, source.File) && target.File != source.File {
-		target.File = target.File + ", " + filepath.Base(source.File)
+// displayFiles renders a class's files as "first/path.h, other.cpp, ..."
+func displayFiles(files []string) string {
+	if len(files) == 1 {
+		return files[0]
+	}
+	n := len(files[0])
+	for _, file := range files[1:] {
+		n += 2 + len(filepath.Base(file))
+	}
+	var b strings.Builder
+	b.Grow(n)
+	b.WriteString(files[0])
+	for _, file := range files[1:] {
+		b.WriteString(", ")
+		b.WriteString(filepath.Base(file))
 	}
+	return b.String()
 }
 
 func isHeaderFile(filename string) bool {
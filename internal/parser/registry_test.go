@@ -0,0 +1,117 @@
+package parser
+
+import (
+	"slices"
+	"testing"
+)
+
+const fooHeader = `class Foo {
+  int *data;
+
+public:
+  Foo();
+  ~Foo();
+};
+`
+
+const fooImpl = `#include "foo.h"
+
+Foo::Foo() { data = new int[4]; }
+Foo::~Foo() { delete data; }
+`
+
+func TestMergeHeaderAndImplementation(t *testing.T) {
+	registry := NewClassRegistry()
+	registry.AddClasses(ParseSource("/src/foo.h", []byte(fooHeader)))
+	registry.AddClasses(ParseSource("/src/foo.cpp", []byte(fooImpl)))
+	merged := registry.MergeClasses()
+	if len(merged) != 1 {
+		t.Fatalf("got %d classes, want 1", len(merged))
+	}
+
+	c := &merged[0]
+	if c.File != "/src/foo.h, foo.cpp" {
+		t.Errorf("File = %q, want \"/src/foo.h, foo.cpp\"", c.File)
+	}
+	if want := []string{"/src/foo.h", "/src/foo.cpp"}; !slices.Equal(c.Files, want) {
+		t.Errorf("Files = %q, want %q", c.Files, want)
+	}
+	if len(c.Members) != 1 || c.Members[0].File != "/src/foo.h" {
+		t.Errorf("members = %+v, want data from foo.h", c.Members)
+	}
+	if c.Constructor == nil || len(c.Constructor.Allocations) != 1 || c.Constructor.Allocations[0].File != "/src/foo.cpp" {
+		t.Errorf("constructor = %+v, want the allocation from foo.cpp", c.Constructor)
+	}
+	if c.Destructor == nil || len(c.Destructor.Deallocations) != 1 {
+		t.Errorf("destructor = %+v, want the deallocation from foo.cpp", c.Destructor)
+	}
+}
+
+func TestMergeNamespaces(t *testing.T) {
+	header := func(file, namespace string) Class {
+		return Class{Name: "Foo", Namespace: namespace, File: file,
+			Members: []Member{{Name: "p", IsPointer: true}}}
+	}
+	impl := func(file string, includes ...string) Class {
+		return Class{Name: "Foo", File: file, Includes: includes,
+			Constructor: &Function{Name: "Foo", Allocations: []Allocation{{VarName: "p"}}}}
+	}
+
+	for _, tc := range []struct {
+		name    string
+		classes []Class
+		want    []string // qualified name and files of each merged class
+	}{
+		{
+			name:    "same namespace",
+			classes: []Class{header("/a.h", "ns"), {Name: "Foo", Namespace: "ns", File: "/a.cpp"}},
+			want:    []string{"ns::Foo /a.h, a.cpp"},
+		},
+		{
+			name:    "implementation without namespace includes its header",
+			classes: []Class{header("/x/one.h", "one"), header("/y/two.h", "two"), impl("/y/two.cpp", "two.h"), impl("/x/b.cpp", "../x/one.h")},
+			want:    []string{"one::Foo /x/one.h, b.cpp", "two::Foo /y/two.h, two.cpp"},
+		},
+		{
+			name:    "implementation seen before its header",
+			classes: []Class{impl("/a.cpp"), header("/one.h", "one"), header("/two.h", "two")},
+			want:    []string{"one::Foo /a.cpp, one.h", "two::Foo /two.h"},
+		},
+		{
+			name:    "different namespaces stay apart",
+			classes: []Class{header("/one.h", "one"), header("/two.h", "two")},
+			want:    []string{"one::Foo /one.h", "two::Foo /two.h"},
+		},
+	} {
+		t.Run(tc.name, func(t *testing.T) {
+			registry := NewClassRegistry()
+			for _, class := range tc.classes {
+				registry.AddClasses([]Class{class})
+			}
+			var got []string
+			for _, c := range registry.MergeClasses() {
+				got = append(got, c.QualifiedName()+" "+c.File)
+			}
+			if !slices.Equal(got, tc.want) {
+				t.Errorf("merged %q, want %q", got, tc.want)
+			}
+		})
+	}
+}
+
+func BenchmarkMergeClasses(b *testing.B) {
+	files, contents := loadCorpus(b)
+	parsed := make([][]Class, len(files))
+	for i, c := range contents {
+		parsed[i] = ParseSource(files[i], c)
+	}
+	b.ReportAllocs()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		registry := NewClassRegistry()
+		for _, classes := range parsed {
+			registry.AddClasses(classes)
+		}
+		registry.MergeClasses()
+	}
+}
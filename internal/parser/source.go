@@ -0,0 +1,42 @@
+package parser
+
+import "os"
+
+// mmapThreshold is the file size from which ReadSource maps files instead
+// of reading them. Below it, a read is cheaper than setting up a mapping.
+const mmapThreshold = 64 * 1024
+
+// UseMmap lets ReadSource memory-map large files. Long-running processes
+// turn it off before parsing starts: a file truncated while it is mapped
+// raises SIGBUS when the mapping is read past its new end.
+var UseMmap = true
+
+// ReadSource returns the content of filename and a function that releases
+// it. Large files are memory-mapped where the platform supports it and
+// UseMmap is set, so their bytes are never copied onto the heap. The
+// content must not be used after release is called.
+func ReadSource(filename string) (content []byte, release func(), err error) {
+	f, err := os.Open(filename)
+	if err != nil {
+		return nil, nil, err
+	}
+	defer f.Close()
+
+	info, err := f.Stat()
+	if err != nil {
+		return nil, nil, err
+	}
+
+	if UseMmap && info.Size() >= mmapThreshold && int64(int(info.Size())) == info.Size() {
+		if data, err := mmapFile(f, int(info.Size())); err == nil {
+			return data, func() { munmapFile(data) }, nil
+		}
+		// Fall back to a plain read if the mapping fails
+	}
+
+	content, err = os.ReadFile(filename)
+	if err != nil {
+		return nil, nil, err
+	}
+	return content, func() {}, nil
+}
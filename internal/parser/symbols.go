@@ -0,0 +1,105 @@
+package parser
+
+import (
+	"strings"
+	"sync"
+	"unsafe"
+)
+
+// symbolShardBits selects the shard from the low bits of the name's hash
+const symbolShardBits = 6
+
+const numSymbolShards = 1 << symbolShardBits
+
+// symbolShard is one lock-striped part of a SymbolTable
+type symbolShard struct {
+	mu    sync.RWMutex
+	names map[string]string
+}
+
+// SymbolTable interns identifiers so that every occurrence of a name across
+// all parsed files shares one string. It is safe for concurrent use by
+// parallel parse workers.
+//
+// Names stay strings rather than integer IDs: they are the Class fields
+// that the cache, shard dumps and JSON output serialize, and the maps
+// keyed by them are per class and small. The analyzer numbers names
+// locally where it needs dense indexes (alias sets, the call graph).
+type SymbolTable struct {
+	shards [numSymbolShards]symbolShard
+}
+
+// Symbols is the run-wide symbol table used by the parser
+var Symbols = NewSymbolTable()
+
+// NewSymbolTable creates an empty symbol table
+func NewSymbolTable() *SymbolTable {
+	t := &SymbolTable{}
+	for i := range t.shards {
+		t.shards[i].names = make(map[string]string)
+	}
+	return t
+}
+
+// Reset empties the table. Strings handed out before stay valid; names
+// interned afterwards just no longer share them. Long-running processes
+// reset between batches so the table does not grow without bound.
+func (t *SymbolTable) Reset() {
+	for i := range t.shards {
+		s := &t.shards[i]
+		s.mu.Lock()
+		s.names = make(map[string]string)
+		s.mu.Unlock()
+	}
+}
+
+// InternBytes returns the shared string for name, adding it if it is new.
+// name is copied only when it is added, so callers may pass a slice of
+// the source buffer.
+func (t *SymbolTable) InternBytes(name []byte) string {
+	return t.intern(bytesView(name))
+}
+
+// InternString returns the shared copy of name
+func (t *SymbolTable) InternString(name string) string {
+	return t.intern(name)
+}
+
+// intern looks name up, cloning it into the table if it is new.
+// name may alias a mutable or unmapped buffer and must not be retained.
+func (t *SymbolTable) intern(name string) string {
+	s := &t.shards[symbolHash(name)&(numSymbolShards-1)]
+
+	s.mu.RLock()
+	str, ok := s.names[name]
+	s.mu.RUnlock()
+	if ok {
+		return str
+	}
+
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if str, ok := s.names[name]; ok {
+		return str
+	}
+	str = strings.Clone(name)
+	s.names[str] = str
+	return str
+}
+
+// symbolHash picks a shard for name. It only needs to spread names across
+// shards, not to be a good hash: the shard's map hashes the full name again.
+func symbolHash(name string) uint32 {
+	if len(name) == 0 {
+		return 0
+	}
+	return uint32(len(name)) ^ uint32(name[0])*31 ^ uint32(name[len(name)-1])*131
+}
+
+// bytesView returns b as a string without copying it
+func bytesView(b []byte) string {
+	if len(b) == 0 {
+		return ""
+	}
+	return unsafe.String(&b[0], len(b))
+}
@@ -0,0 +1,23 @@
+package parser
+
+import (
+	"testing"
+	"unsafe"
+)
+
+func TestSymbolTable(t *testing.T) {
+	table := NewSymbolTable()
+	buf := []byte("widget")
+	first := table.InternBytes(buf)
+	buf[0] = 'm' // the table keeps its own copy
+	if first != "widget" {
+		t.Fatalf("interned %q, want widget", first)
+	}
+	if again := table.InternString("widget"); unsafe.StringData(again) != unsafe.StringData(first) {
+		t.Error("second intern of widget returned a different string")
+	}
+	table.Reset()
+	if after := table.InternString("widget"); after != "widget" || unsafe.StringData(after) == unsafe.StringData(first) {
+		t.Error("intern after Reset returned the string from before")
+	}
+}
@@ -1,7 +1,9 @@
 package parser
 
-// Token represents a lexical token from C++ source
-type TokenType int
+import "strings"
+
+// TokenType classifies a lexical token
+type TokenType uint8
 
 const (
 	TokenEOF TokenType = iota
@@ -14,17 +16,36 @@ const (
 	TokenNewline
 )
 
+// Token represents a lexical token from C++ source.
+// The token text is not copied; it is the Len bytes at offset Start
+// of the source the token was lexed from.
 type Token struct {
 	Type   TokenType
-	Value  string
-	Line   int
-	Column int
+	Kind   Kind // Keyword, operator or punctuation ID; KindNone otherwise
+	Start  int32
+	Len    int32
+	Line   int32
+	Column int32
+}
+
+// Text returns a copy of the token's text in src
+func (t Token) Text(src []byte) string {
+	return string(src[t.Start : t.Start+t.Len])
 }
 
 // Class represents a C++ class or struct
 type Class struct {
-	Name        string
-	File        string
+	Name string
+	// Namespace is the enclosing namespace, qualified ("a::b"); empty at
+	// global scope or when a definition does not name it
+	Namespace string
+	File      string
+	// Files lists the full paths of a class merged from several files, the
+	// first one first; nil for a class from one file
+	Files []string
+	// Includes lists the #include targets of File, as written; the classes
+	// of one file share the slice
+	Includes    []string
 	StartLine   int
 	EndLine     int
 	Members     []Member
@@ -33,6 +54,53 @@ type Class struct {
 	Methods     []Function
 }
 
+// QualifiedName returns the class name with its namespace, e.g. "ns::Foo"
+func (c *Class) QualifiedName() string {
+	if c.Namespace == "" {
+		return c.Name
+	}
+	return c.Namespace + "::" + c.Name
+}
+
+// SetFile records file as the source of the class and of everything in
+// it. Merged classes keep these per-item files, so a finding can name the
+// file its line is in.
+func (c *Class) SetFile(file string) {
+	c.File = file
+	for i := range c.Members {
+		c.Members[i].File = file
+	}
+	c.Constructor.setFile(file)
+	c.Destructor.setFile(file)
+	for i := range c.Methods {
+		c.Methods[i].setFile(file)
+	}
+}
+
+func (fn *Function) setFile(file string) {
+	if fn == nil {
+		return
+	}
+	fn.File = file
+	for i := range fn.Allocations {
+		fn.Allocations[i].File = file
+	}
+	for i := range fn.Deallocations {
+		fn.Deallocations[i].File = file
+	}
+	for i := range fn.Aliases {
+		fn.Aliases[i].File = file
+	}
+}
+
+// BaseName returns the class name of a qualified name, e.g. "Foo" for "ns::Foo"
+func BaseName(qualified string) string {
+	if i := strings.LastIndex(qualified, "::"); i >= 0 {
+		return qualified[i+2:]
+	}
+	return qualified
+}
+
 // Member represents a class member variable
 type Member struct {
 	Name      string
@@ -40,11 +108,13 @@ type Member struct {
 	IsPointer bool
 	IsArray   bool
 	Line      int
+	File      string // file the declaration is in, see Class.SetFile
 }
 
 // Function represents a class method (constructor, destructor, or regular method)
 type Function struct {
 	Name          string
+	File          string // file the definition is in, see Class.SetFile
 	IsDestructor  bool
 	StartLine     int
 	EndLine       int
@@ -59,6 +129,7 @@ type Allocation struct {
 	VarName string
 	IsArray bool // true for new[], false for new
 	Line    int
+	File    string
 }
 
 // Deallocation represents a dynamic memory deallocation
@@ -66,6 +137,7 @@ type Deallocation struct {
 	VarName string
 	IsArray bool // true for delete[], false for delete
 	Line    int
+	File    string
 }
 
 // PointerAlias represents when one pointer is assigned to another
@@ -73,15 +145,28 @@ type PointerAlias struct {
 	SourceVar string // original pointer (e.g., ptr1)
 	TargetVar string // alias pointer (e.g., ptr2 = ptr1)
 	Line      int
+	File      string
 }
 
 // Leak represents a detected memory leak
 type Leak struct {
-	File           string `json:"file"`
-	Line           int    `json:"line"`
-	ClassName      string `json:"class"`
-	VarName        string `json:"variable"`
-	Reason         string `json:"reason"`
-	Severity       string `json:"severity"`       // "error", "warning"
-	Recommendation string `json:"recommendation"` // How to fix
+	File           string   `json:"file"`            // the class's files, see ClassRegistry.MergeClasses
+	SourceFile     string   `json:"source_file"`     // the file Line is in
+	Files          []string `json:"files,omitempty"` // full paths when File lists several
+	Line           int      `json:"line"`
+	ClassName      string   `json:"class"` // qualified, e.g. "ns::Foo"
+	VarName        string   `json:"variable"`
+	Reason         string   `json:"reason"`
+	Severity       string   `json:"severity"`       // "error", "warning"
+	Rule           string   `json:"rule"`           // One of the Rule* IDs
+	Recommendation string   `json:"recommendation"` // How to fix
 }
+
+// Rule IDs identify which check produced a Leak
+const (
+	RuleMissingDelete = "missing-delete" // allocated in the constructor, not freed by the destructor
+	RuleArrayMismatch = "array-mismatch" // new[] freed with delete, or new freed with delete[]
+	RuleReassignment  = "reassignment"   // member reassigned with new without freeing it first
+	RuleDoubleFree    = "double-free"    // a pointer and its alias are both deleted
+	RuleNoDestructor  = "no-destructor"  // allocated member in a class without a destructor
+)
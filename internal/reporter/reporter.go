@@ -1,44 +1,189 @@
 package reporter
 
 import (
+	"bufio"
 	"encoding/json"
 	"fmt"
 	"io"
 	"leakcheck/internal/parser"
 	"path/filepath"
+	"runtime"
 	"sort"
+	"sync/atomic"
 )
 
+// Format selects how findings are written
+type Format string
+
+const (
+	// FormatConsole is the human-readable report, grouped by file
+	FormatConsole Format = "console"
+	// FormatJSON is a single JSON document with all leaks and a summary
+	FormatJSON Format = "json"
+	// FormatNDJSON is one JSON record per line: a "leak" record per finding,
+	// written as soon as it is found, and a closing "summary" record
+	FormatNDJSON Format = "ndjson"
+	// FormatSARIF is a SARIF 2.1.0 log for code-scanning tools, with results
+	// written as soon as they are found
+	FormatSARIF Format = "sarif"
+)
+
+// Streams reports whether findings in this format are written while the
+// analysis is running (see Reporter.Stream)
+func (f Format) Streams() bool {
+	return f == FormatNDJSON || f == FormatSARIF
+}
+
+// ParseFormat returns the Format named by s
+func ParseFormat(s string) (Format, error) {
+	switch f := Format(s); f {
+	case FormatConsole, FormatJSON, FormatNDJSON, FormatSARIF:
+		return f, nil
+	}
+	return "", fmt.Errorf("unknown format %q (want console, json, ndjson or sarif)", s)
+}
+
 // Reporter formats and outputs leak detection results
 type Reporter struct {
-	output io.Writer
-	json   bool
+	output      io.Writer
+	format      Format
+	toolVersion string
+	workers     int // console formatting goroutines; 0 means GOMAXPROCS
+	maxPerFile  int // findings shown per file in the console report; 0 means all
 }
 
 // NewReporter creates a new reporter
-func NewReporter(output io.Writer, jsonOutput bool) *Reporter {
+func NewReporter(output io.Writer, format Format) *Reporter {
 	return &Reporter{
 		output: output,
-		json:   jsonOutput,
+		format: format,
 	}
 }
 
+// SetToolVersion sets the leakcheck version recorded in SARIF output
+func (r *Reporter) SetToolVersion(version string) {
+	r.toolVersion = version
+}
+
+// SetWorkers sets the number of goroutines formatting the console report
+func (r *Reporter) SetWorkers(n int) {
+	r.workers = n
+}
+
+// SetMaxFindingsPerFile limits the console report to the first n findings
+// of each file, by line; the rest are counted in a note and the summary.
+// n <= 0 shows every finding.
+func (r *Reporter) SetMaxFindingsPerFile(n int) {
+	r.maxPerFile = n
+}
+
 // Report outputs the leak findings
 func (r *Reporter) Report(leaks []parser.Leak) error {
-	if r.json {
+	switch {
+	case r.format == FormatJSON:
 		return r.reportJSON(leaks)
+	case r.format.Streams():
+		stream := r.Stream()
+		stream.Write(leaks)
+		return stream.Close()
 	}
 	return r.reportConsole(leaks)
 }
 
+// streamBufferSize is the size of the buffered writer used by Stream
+const streamBufferSize = 64 * 1024
+
+// Stream writes findings incrementally as NDJSON records or SARIF results,
+// so they can be consumed while the analysis is still running and never
+// have to be held in memory all at once
+type Stream struct {
+	format  Format
+	w       *bufio.Writer
+	enc     *json.Encoder
+	summary Summary
+	err     error
+}
+
+// leakRecord is the NDJSON form of a finding
+type leakRecord struct {
+	Type string `json:"type"`
+	parser.Leak
+}
+
+// summaryRecord is the NDJSON record that closes a stream
+type summaryRecord struct {
+	Type string `json:"type"`
+	Summary
+}
+
+// Stream starts a stream in the reporter's format, which must be one for
+// which Format.Streams is true
+func (r *Reporter) Stream() *Stream {
+	w := bufio.NewWriterSize(r.output, streamBufferSize)
+	s := &Stream{format: r.format, w: w, enc: json.NewEncoder(w)}
+	if s.format == FormatSARIF {
+		_, s.err = w.Write(sarifHeader(r.toolVersion))
+	}
+	return s
+}
+
+// Write writes one record per leak. After a write error, further writes
+// are dropped and the error is returned by Write and Close.
+func (s *Stream) Write(leaks []parser.Leak) error {
+	for i := range leaks {
+		if s.err != nil {
+			return s.err
+		}
+		leak := &leaks[i]
+		if s.format == FormatSARIF {
+			if s.summary.TotalIssues > 0 {
+				s.err = s.w.WriteByte(',')
+			}
+			if s.err == nil {
+				s.err = s.enc.Encode(newSARIFResult(leak))
+			}
+		} else {
+			s.err = s.enc.Encode(leakRecord{Type: "leak", Leak: *leak})
+		}
+		s.summary.add(leak)
+	}
+	return s.err
+}
+
+// Close ends the stream (the NDJSON summary record, or the end of the SARIF
+// document) and flushes it
+func (s *Stream) Close() error {
+	if s.err == nil {
+		if s.format == FormatSARIF {
+			_, s.err = s.w.WriteString(sarifFooter)
+		} else {
+			s.err = s.enc.Encode(summaryRecord{Type: "summary", Summary: s.summary})
+		}
+	}
+	if err := s.w.Flush(); s.err == nil {
+		s.err = err
+	}
+	return s.err
+}
+
+// Summary returns the totals of the leaks written so far
+func (s *Stream) Summary() Summary {
+	return s.summary
+}
+
+// parallelGroups is the number of files from which the console report
+// formats files concurrently; below it the goroutines cost more than they save
+const parallelGroups = 64
+
 func (r *Reporter) reportConsole(leaks []parser.Leak) error {
+	w := bufio.NewWriterSize(r.output, streamBufferSize)
 	if len(leaks) == 0 {
-		fmt.Fprintln(r.output, "[OK] No potential memory leaks detected.")
-		return nil
+		fmt.Fprintln(w, "[OK] No potential memory leaks detected.")
+		return w.Flush()
 	}
 
-	// Sort by file, then line
-	sort.Slice(leaks, func(i, j int) bool {
+	// Sort by file, then line; leaks on the same line keep their analysis order
+	sort.SliceStable(leaks, func(i, j int) bool {
 		if leaks[i].File != leaks[j].File {
 			return leaks[i].File < leaks[j].File
 		}
@@ -46,40 +191,90 @@ func (r *Reporter) reportConsole(leaks []parser.Leak) error {
 	})
 
 	// Group by file
-	currentFile := ""
-	for _, leak := range leaks {
-		if leak.File != currentFile {
-			currentFile = leak.File
-			relPath := filepath.Base(currentFile)
-			fmt.Fprintf(r.output, "\n%s:\n", relPath)
+	var groups [][]parser.Leak
+	for start := 0; start < len(leaks); {
+		end := start + 1
+		for end < len(leaks) && leaks[end].File == leaks[start].File {
+			end++
 		}
+		groups = append(groups, leaks[start:end])
+		start = end
+	}
 
+	workers := r.workers
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	if workers == 1 || len(groups) < parallelGroups {
+		var buf []byte
+		for _, group := range groups {
+			buf = r.formatGroup(buf[:0], group)
+			w.Write(buf)
+		}
+	} else {
+		// Format files concurrently and write them in order, each as soon
+		// as it and every file before it are done
+		formatted := make([][]byte, len(groups))
+		done := make([]chan struct{}, len(groups))
+		for i := range done {
+			done[i] = make(chan struct{})
+		}
+		var next atomic.Int64
+		for n := 0; n < min(workers, len(groups)); n++ {
+			go func() {
+				for {
+					i := int(next.Add(1) - 1)
+					if i >= len(groups) {
+						return
+					}
+					formatted[i] = r.formatGroup(nil, groups[i])
+					close(done[i])
+				}
+			}()
+		}
+		for i := range groups {
+			<-done[i]
+			w.Write(formatted[i])
+			formatted[i] = nil
+		}
+	}
+
+	// Summary
+	summary := Summarize(leaks)
+	fmt.Fprintf(w, "\nSummary: %d error(s), %d warning(s)\n", summary.Errors, summary.TotalIssues-summary.Errors)
+	return w.Flush()
+}
+
+// formatGroup appends the console report for the leaks of one file to buf.
+// With a per-file limit set, the findings past it are only counted.
+func (r *Reporter) formatGroup(buf []byte, leaks []parser.Leak) []byte {
+	buf = append(buf, '\n')
+	buf = append(buf, filepath.Base(leaks[0].File)...)
+	buf = append(buf, ":\n"...)
+
+	shown := leaks
+	if r.maxPerFile > 0 && len(shown) > r.maxPerFile {
+		shown = shown[:r.maxPerFile]
+	}
+	for i := range shown {
+		leak := &shown[i]
 		icon := "[ERROR]"
 		if leak.Severity == "warning" {
 			icon = "[WARN] "
 		}
-
-		fmt.Fprintf(r.output, "  %s Line %d [%s::%s]: %s\n",
+		buf = fmt.Appendf(buf, "  %s Line %d [%s::%s]: %s\n",
 			icon, leak.Line, leak.ClassName, leak.VarName, leak.Reason)
 
 		if leak.Recommendation != "" {
-			fmt.Fprintf(r.output, "         -> Fix: %s\n", leak.Recommendation)
+			buf = append(buf, "         -> Fix: "...)
+			buf = append(buf, leak.Recommendation...)
+			buf = append(buf, '\n')
 		}
 	}
-
-	// Summary
-	errors := 0
-	warnings := 0
-	for _, leak := range leaks {
-		if leak.Severity == "error" {
-			errors++
-		} else {
-			warnings++
-		}
+	if hidden := len(leaks) - len(shown); hidden > 0 {
+		buf = fmt.Appendf(buf, "  ... %d more finding(s) in this file (see --max-findings)\n", hidden)
 	}
-
-	fmt.Fprintf(r.output, "\nSummary: %d error(s), %d warning(s)\n", errors, warnings)
-	return nil
+	return buf
 }
 
 func (r *Reporter) reportJSON(leaks []parser.Leak) error {
@@ -87,12 +282,8 @@ func (r *Reporter) reportJSON(leaks []parser.Leak) error {
 		Leaks   []parser.Leak `json:"leaks"`
 		Summary Summary       `json:"summary"`
 	}{
-		Leaks: leaks,
-		Summary: Summary{
-			TotalIssues: len(leaks),
-			Errors:      countBySeverity(leaks, "error"),
-			Warnings:    countBySeverity(leaks, "warning"),
-		},
+		Leaks:   leaks,
+		Summary: Summarize(leaks),
 	}
 
 	if output.Leaks == nil {
@@ -111,6 +302,26 @@ type Summary struct {
 	Warnings    int `json:"warnings"`
 }
 
+// add counts one leak into the summary
+func (s *Summary) add(leak *parser.Leak) {
+	s.TotalIssues++
+	switch leak.Severity {
+	case "error":
+		s.Errors++
+	case "warning":
+		s.Warnings++
+	}
+}
+
+// Summarize returns the totals of leaks
+func Summarize(leaks []parser.Leak) Summary {
+	return Summary{
+		TotalIssues: len(leaks),
+		Errors:      countBySeverity(leaks, "error"),
+		Warnings:    countBySeverity(leaks, "warning"),
+	}
+}
+
 func countBySeverity(leaks []parser.Leak, severity string) int {
 	count := 0
 	for _, leak := range leaks {
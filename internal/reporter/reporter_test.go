@@ -0,0 +1,157 @@
+package reporter
+
+import (
+	"bytes"
+	"encoding/json"
+	"fmt"
+	"io"
+	"strings"
+	"testing"
+
+	"leakcheck/internal/parser"
+)
+
+func testLeaks() []parser.Leak {
+	return []parser.Leak{
+		{File: "/src/b.cpp", SourceFile: "/src/b.cpp", Line: 9, ClassName: "B", VarName: "q",
+			Reason: "reassigned", Severity: "warning", Rule: parser.RuleReassignment},
+		{File: "/src/a.h, a.cpp", Files: []string{"/src/a.h", "/src/a.cpp"}, SourceFile: "/src/a.cpp", Line: 3,
+			ClassName: "ns::A", VarName: "p", Reason: "not deleted", Severity: "error", Rule: parser.RuleMissingDelete,
+			Recommendation: "delete p"},
+	}
+}
+
+func report(t *testing.T, format Format, leaks []parser.Leak) string {
+	t.Helper()
+	var out bytes.Buffer
+	if err := NewReporter(&out, format).Report(leaks); err != nil {
+		t.Fatal(err)
+	}
+	return out.String()
+}
+
+func TestConsole(t *testing.T) {
+	out := report(t, FormatConsole, testLeaks())
+	a := strings.Index(out, "a.h, a.cpp:\n  [ERROR] Line 3 [ns::A::p]: not deleted\n         -> Fix: delete p\n")
+	b := strings.Index(out, "b.cpp:\n  [WARN]  Line 9 [B::q]: reassigned\n")
+	if a < 0 || b < a {
+		t.Errorf("console report:\n%s", out)
+	}
+	if !strings.HasSuffix(out, "Summary: 1 error(s), 1 warning(s)\n") {
+		t.Errorf("console summary:\n%s", out)
+	}
+
+	if out := report(t, FormatConsole, nil); !strings.Contains(out, "No potential memory leaks") {
+		t.Errorf("report without findings: %q", out)
+	}
+}
+
+func TestMaxFindingsPerFile(t *testing.T) {
+	var leaks []parser.Leak
+	for line := 1; line <= 5; line++ {
+		leaks = append(leaks, parser.Leak{File: "/src/a.cpp", Line: line, Severity: "error"})
+	}
+	var out bytes.Buffer
+	r := NewReporter(&out, FormatConsole)
+	r.SetMaxFindingsPerFile(2)
+	if err := r.Report(leaks); err != nil {
+		t.Fatal(err)
+	}
+	if n := strings.Count(out.String(), "[ERROR]"); n != 2 || !strings.Contains(out.String(), "3 more finding(s)") {
+		t.Errorf("report limited to 2 per file:\n%s", out.String())
+	}
+}
+
+func TestJSON(t *testing.T) {
+	var doc struct {
+		Leaks   []parser.Leak `json:"leaks"`
+		Summary Summary       `json:"summary"`
+	}
+	if err := json.Unmarshal([]byte(report(t, FormatJSON, testLeaks())), &doc); err != nil {
+		t.Fatal(err)
+	}
+	if len(doc.Leaks) != 2 || doc.Leaks[1].SourceFile != "/src/a.cpp" || doc.Summary != (Summary{2, 1, 1}) {
+		t.Errorf("decoded %+v", doc)
+	}
+	if out := report(t, FormatJSON, nil); !strings.Contains(out, `"leaks": []`) {
+		t.Errorf("JSON without findings: %s", out)
+	}
+}
+
+func TestNDJSON(t *testing.T) {
+	lines := strings.Split(strings.TrimSpace(report(t, FormatNDJSON, testLeaks())), "\n")
+	if len(lines) != 3 {
+		t.Fatalf("got %d records, want 2 leaks and a summary", len(lines))
+	}
+	for i, want := range []string{"leak", "leak", "summary"} {
+		var record struct{ Type string }
+		if err := json.Unmarshal([]byte(lines[i]), &record); err != nil || record.Type != want {
+			t.Errorf("record %d = %s, want type %s", i, lines[i], want)
+		}
+	}
+}
+
+func TestSARIF(t *testing.T) {
+	var log struct {
+		Runs []struct {
+			Results []struct {
+				RuleID    string `json:"ruleId"`
+				Level     string `json:"level"`
+				Locations []struct {
+					PhysicalLocation struct {
+						ArtifactLocation struct{ URI string } `json:"artifactLocation"`
+						Region           struct{ StartLine int }
+					} `json:"physicalLocation"`
+				}
+				Properties *struct{ ClassFiles []string }
+			}
+		}
+	}
+	if err := json.Unmarshal([]byte(report(t, FormatSARIF, testLeaks())), &log); err != nil {
+		t.Fatal(err)
+	}
+	results := log.Runs[0].Results
+	if len(results) != 2 {
+		t.Fatalf("got %d results, want 2", len(results))
+	}
+	if r := results[0]; r.Level != "warning" || r.Properties != nil {
+		t.Errorf("single-file result = %+v", r)
+	}
+	// A merged class points at the file of the line, and lists all of them
+	r := results[1]
+	location := r.Locations[0].PhysicalLocation
+	if r.RuleID != parser.RuleMissingDelete || location.ArtifactLocation.URI != "file:///src/a.cpp" || location.Region.StartLine != 3 {
+		t.Errorf("merged-class result = %+v", r)
+	}
+	if r.Properties == nil || fmt.Sprint(r.Properties.ClassFiles) != "[/src/a.h /src/a.cpp]" {
+		t.Errorf("classFiles = %+v", r.Properties)
+	}
+}
+
+func TestFileURI(t *testing.T) {
+	for _, tc := range []struct{ path, want string }{
+		{"/src/a b.cpp", "file:///src/a%20b.cpp"},
+		{"src/a.cpp", "src/a.cpp"},
+	} {
+		if got := fileURI(tc.path); got != tc.want {
+			t.Errorf("fileURI(%q) = %q, want %q", tc.path, got, tc.want)
+		}
+	}
+}
+
+func BenchmarkReportConsole(b *testing.B) {
+	var leaks []parser.Leak
+	for file := 0; file < 500; file++ {
+		for line := 1; line <= 10; line++ {
+			leaks = append(leaks, parser.Leak{File: fmt.Sprintf("/src/f%03d.cpp", file), Line: line, ClassName: "A", VarName: "p",
+				Reason: "allocated with 'new' but not deleted in destructor", Severity: "error", Recommendation: "delete p"})
+		}
+	}
+	b.ReportAllocs()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		if err := NewReporter(io.Discard, FormatConsole).Report(leaks); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
@@ -0,0 +1,213 @@
+package reporter
+
+import (
+	"encoding/json"
+	"leakcheck/internal/parser"
+	"net/url"
+	"path/filepath"
+	"strings"
+	"sync"
+)
+
+// sarifSchema and sarifVersion identify the SARIF format written by FormatSARIF
+const (
+	sarifSchema  = "https://json.schemastore.org/sarif-2.1.0.json"
+	sarifVersion = "2.1.0"
+)
+
+// sarifRule describes one rule in the tool.driver.rules array
+type sarifRule struct {
+	ID               string            `json:"id"`
+	Name             string            `json:"name"`
+	ShortDescription sarifText         `json:"shortDescription"`
+	FullDescription  sarifText         `json:"fullDescription"`
+	Help             sarifText         `json:"help"`
+	Default          sarifRuleDefaults `json:"defaultConfiguration"`
+}
+
+type sarifRuleDefaults struct {
+	Level string `json:"level"`
+}
+
+type sarifText struct {
+	Text string `json:"text"`
+}
+
+// sarifRules is the rule table, in the order of the rules array.
+// Results refer to rules by their index in it.
+var sarifRules = []sarifRule{
+	{
+		ID:               parser.RuleMissingDelete,
+		Name:             "MissingDelete",
+		ShortDescription: sarifText{"Allocation not deleted in destructor"},
+		FullDescription:  sarifText{"A pointer member allocated with new in the constructor is not deleted by the destructor or any method it calls."},
+		Help:             sarifText{"Delete the member in the destructor, or hold it in a std::unique_ptr."},
+		Default:          sarifRuleDefaults{"error"},
+	},
+	{
+		ID:               parser.RuleArrayMismatch,
+		Name:             "ArrayMismatch",
+		ShortDescription: sarifText{"Mismatched new[]/delete"},
+		FullDescription:  sarifText{"Memory allocated with new[] is freed with delete, or memory allocated with new is freed with delete[]."},
+		Help:             sarifText{"Use delete[] for arrays allocated with new[], and delete for single objects."},
+		Default:          sarifRuleDefaults{"error"},
+	},
+	{
+		ID:               parser.RuleReassignment,
+		Name:             "Reassignment",
+		ShortDescription: sarifText{"Pointer reassigned without delete"},
+		FullDescription:  sarifText{"A pointer member that already owns an allocation is assigned a new allocation without deleting the previous one."},
+		Help:             sarifText{"Delete the previous value before reassigning, or hold it in a std::unique_ptr."},
+		Default:          sarifRuleDefaults{"warning"},
+	},
+	{
+		ID:               parser.RuleDoubleFree,
+		Name:             "DoubleFree",
+		ShortDescription: sarifText{"Pointer and alias both deleted"},
+		FullDescription:  sarifText{"A pointer member is copied to another pointer and both are deleted, freeing the same memory twice."},
+		Help:             sarifText{"Delete only one of the pointers, or set the other to nullptr after deleting."},
+		Default:          sarifRuleDefaults{"error"},
+	},
+	{
+		ID:               parser.RuleNoDestructor,
+		Name:             "NoDestructor",
+		ShortDescription: sarifText{"Allocated member without destructor"},
+		FullDescription:  sarifText{"A class allocates a pointer member with new but declares no destructor to free it."},
+		Help:             sarifText{"Add a destructor that deletes the member, or hold it in a std::unique_ptr."},
+		Default:          sarifRuleDefaults{"error"},
+	},
+}
+
+var (
+	sarifRulesOnce sync.Once
+	sarifRulesJSON []byte         // the marshalled rules array
+	sarifRuleIndex map[string]int // rule ID -> index in sarifRules
+)
+
+// sarifRuleTable returns the marshalled rules array and the index of each
+// rule, building them on first use
+func sarifRuleTable() ([]byte, map[string]int) {
+	sarifRulesOnce.Do(func() {
+		sarifRulesJSON, _ = json.Marshal(sarifRules)
+		sarifRuleIndex = make(map[string]int, len(sarifRules))
+		for i, rule := range sarifRules {
+			sarifRuleIndex[rule.ID] = i
+		}
+	})
+	return sarifRulesJSON, sarifRuleIndex
+}
+
+// sarifResult is one entry of runs[0].results
+type sarifResult struct {
+	RuleID    string          `json:"ruleId"`
+	RuleIndex int             `json:"ruleIndex"`
+	Level     string          `json:"level"`
+	Message   sarifText       `json:"message"`
+	Locations []sarifLocation `json:"locations"`
+	// The files of a class merged from several, when the one the location
+	// names is only part of it
+	Properties *sarifProperties `json:"properties,omitempty"`
+}
+
+type sarifProperties struct {
+	ClassFiles []string `json:"classFiles"`
+}
+
+type sarifLocation struct {
+	Physical sarifPhysicalLocation  `json:"physicalLocation"`
+	Logical  []sarifLogicalLocation `json:"logicalLocations,omitempty"`
+}
+
+type sarifPhysicalLocation struct {
+	Artifact sarifArtifact `json:"artifactLocation"`
+	Region   sarifRegion   `json:"region"`
+}
+
+type sarifArtifact struct {
+	URI string `json:"uri"`
+}
+
+type sarifRegion struct {
+	StartLine int `json:"startLine"`
+}
+
+type sarifLogicalLocation struct {
+	FullyQualifiedName string `json:"fullyQualifiedName"`
+	Kind               string `json:"kind"`
+}
+
+// sarifHeader returns everything before the first result
+func sarifHeader(toolVersion string) []byte {
+	rules, _ := sarifRuleTable()
+	driver, _ := json.Marshal(struct {
+		Name    string          `json:"name"`
+		Version string          `json:"version,omitempty"`
+		Rules   json.RawMessage `json:"rules"`
+	}{"leakcheck", toolVersion, rules})
+
+	header := `{"$schema":"` + sarifSchema + `","version":"` + sarifVersion + `","runs":[{"tool":{"driver":`
+	return append(append([]byte(header), driver...), `},"results":[`...)
+}
+
+// sarifFooter closes the document opened by sarifHeader
+const sarifFooter = "]}]}\n"
+
+// newSARIFResult converts a finding to a SARIF result
+func newSARIFResult(leak *parser.Leak) sarifResult {
+	_, index := sarifRuleTable()
+	level := "error"
+	if leak.Severity == "warning" {
+		level = "warning"
+	}
+	text := leak.Reason
+	if leak.Recommendation != "" {
+		text += ". " + leak.Recommendation
+	}
+	file := leak.SourceFile
+	if file == "" {
+		file = primaryFile(leak.File)
+	}
+	var props *sarifProperties
+	if len(leak.Files) > 1 {
+		props = &sarifProperties{ClassFiles: leak.Files}
+	}
+	return sarifResult{
+		RuleID:    leak.Rule,
+		RuleIndex: index[leak.Rule],
+		Level:     level,
+		Message:   sarifText{text},
+		Locations: []sarifLocation{{
+			Physical: sarifPhysicalLocation{
+				Artifact: sarifArtifact{URI: fileURI(file)},
+				Region:   sarifRegion{StartLine: leak.Line},
+			},
+			Logical: []sarifLogicalLocation{{
+				FullyQualifiedName: leak.ClassName + "::" + leak.VarName,
+				Kind:               "member",
+			}},
+		}},
+		Properties: props,
+	}
+}
+
+// primaryFile returns the first file of a merged class's file list
+// ("a.h, a.cpp" -> "a.h")
+func primaryFile(file string) string {
+	if i := strings.Index(file, ", "); i >= 0 {
+		return file[:i]
+	}
+	return file
+}
+
+// fileURI converts a path to a file:// URI, or a relative URI reference
+// for relative paths
+func fileURI(path string) string {
+	path = filepath.ToSlash(path)
+	if !strings.HasPrefix(path, "/") {
+		if filepath.VolumeName(path) == "" {
+			return (&url.URL{Path: path}).String()
+		}
+		path = "/" + path // Windows drive letter
+	}
+	return (&url.URL{Scheme: "file", Path: path}).String()
+}
@@ -0,0 +1,254 @@
+package scanner
+
+import (
+	"bufio"
+	"os"
+	"path"
+	"path/filepath"
+	"strings"
+)
+
+// ignoreFileNames are the files whose patterns the walk honors, read in
+// this order from each directory, so .leakcheckignore can override .gitignore
+var ignoreFileNames = []string{".gitignore", ".leakcheckignore"}
+
+// gitIgnoreFileNames are the ignore files honored on top of git's own rules
+// when files are listed with git ls-files
+var gitIgnoreFileNames = []string{".leakcheckignore"}
+
+// ignorePattern is one compiled line of an ignore file
+type ignorePattern struct {
+	negate  bool // "!pattern" re-includes what an earlier pattern ignored
+	dirOnly bool // "pattern/" only matches directories
+	// anchored patterns contain a slash and match the path relative to the
+	// ignore file's directory; the others match the base name at any depth
+	anchored bool
+	segments []string // split on "/"; a "**" segment matches any number of segments
+	literal  bool     // a single segment without wildcards, compared directly
+}
+
+// ignoreRules holds the patterns of one directory's ignore files
+type ignoreRules struct {
+	patterns []ignorePattern
+}
+
+// loadIgnoreRules reads the named ignore files in dir, or returns nil if it
+// has none
+func loadIgnoreRules(dir string, names []string) *ignoreRules {
+	var rules *ignoreRules
+	for _, name := range names {
+		f, err := os.Open(filepath.Join(dir, name))
+		if err != nil {
+			continue
+		}
+		if rules == nil {
+			rules = &ignoreRules{}
+		}
+		lines := bufio.NewScanner(f)
+		for lines.Scan() {
+			if p, ok := compileIgnorePattern(lines.Text()); ok {
+				rules.patterns = append(rules.patterns, p)
+			}
+		}
+		f.Close()
+	}
+	return rules
+}
+
+// compileIgnorePattern compiles one line in .gitignore syntax. Supported
+// are comments, "!" negation, a trailing "/" for directories, anchoring by
+// a slash, "*", "?", bracket expressions ("[!...]" or "[^...]" negated) and
+// "**" segments. Not supported are POSIX classes such as "[[:digit:]]" and
+// escaped trailing spaces; .git/info/exclude and core.excludesFile are not
+// read either.
+func compileIgnorePattern(line string) (ignorePattern, bool) {
+	line = strings.TrimRight(line, " \t\r")
+	if line == "" || line[0] == '#' {
+		return ignorePattern{}, false
+	}
+
+	var p ignorePattern
+	if line[0] == '!' {
+		p.negate = true
+		line = line[1:]
+	} else if line[0] == '\\' {
+		line = line[1:] // escaped leading # or !
+	}
+	if strings.HasSuffix(line, "/") {
+		p.dirOnly = true
+		line = strings.TrimRight(line, "/")
+	}
+	if strings.Contains(line, "/") {
+		p.anchored = true
+		line = strings.TrimLeft(line, "/")
+	}
+	if line == "" {
+		return ignorePattern{}, false
+	}
+	line = strings.ReplaceAll(line, "[!", "[^") // path.Match negates with ^
+	p.segments = strings.Split(line, "/")
+	p.literal = !p.anchored && !strings.ContainsAny(line, `*?[\`)
+	return p, true
+}
+
+// match reports whether the rules decide rel (slash-separated, relative to
+// the rules' directory), and if so whether it is ignored. The last matching
+// pattern wins, as in git.
+func (r *ignoreRules) match(rel string, isDir bool) (decided, ignored bool) {
+	base := rel[strings.LastIndexByte(rel, '/')+1:]
+	for i := len(r.patterns) - 1; i >= 0; i-- {
+		p := &r.patterns[i]
+		if p.dirOnly && !isDir {
+			continue
+		}
+		var ok bool
+		switch {
+		case p.literal:
+			ok = base == p.segments[0]
+		case !p.anchored:
+			ok, _ = path.Match(p.segments[0], base)
+		default:
+			ok = matchSegments(p.segments, strings.Split(rel, "/"))
+		}
+		if ok {
+			return true, !p.negate
+		}
+	}
+	return false, false
+}
+
+// matchSegments matches path segments against pattern segments, where a
+// "**" segment matches zero or more path segments, except at the end: as
+// in git, "foo/**" matches everything inside foo but not foo itself
+func matchSegments(pattern, parts []string) bool {
+	for len(pattern) > 0 {
+		if pattern[0] == "**" {
+			if len(pattern) == 1 {
+				return len(parts) > 0
+			}
+			for skip := 0; skip <= len(parts); skip++ {
+				if matchSegments(pattern[1:], parts[skip:]) {
+					return true
+				}
+			}
+			return false
+		}
+		if len(parts) == 0 {
+			return false
+		}
+		if ok, _ := path.Match(pattern[0], parts[0]); !ok {
+			return false
+		}
+		pattern, parts = pattern[1:], parts[1:]
+	}
+	return len(parts) == 0
+}
+
+// ignoreChecker decides paths below top against the ignore files of their
+// directories. Each directory's files are read once, the first time a path
+// in it is checked.
+type ignoreChecker struct {
+	top   string
+	names []string                // ignore file names read from each directory
+	rules map[string]*ignoreRules // by directory, slash-separated relative to top
+	dirs  map[string]bool         // memoized ignored() results for directories
+}
+
+func newIgnoreChecker(top string, names []string) *ignoreChecker {
+	return &ignoreChecker{
+		top:   top,
+		names: names,
+		rules: make(map[string]*ignoreRules),
+		dirs:  make(map[string]bool),
+	}
+}
+
+// newWalkChecker returns a checker for the paths below root, with top the
+// git work tree root containing root (or root itself outside a work tree),
+// and the prefix that turns a path relative to root into one relative to
+// top. Root and the directories above it are never ignored, since root was
+// named explicitly.
+func newWalkChecker(root string, names []string) (*ignoreChecker, string) {
+	abs, err := filepath.Abs(root)
+	if err != nil {
+		return nil, ""
+	}
+	top := repoTop(abs)
+	if top == "" {
+		top = abs
+	}
+	c := newIgnoreChecker(top, names)
+	rel, err := filepath.Rel(top, abs)
+	if err != nil || rel == "." {
+		return c, ""
+	}
+	rel = filepath.ToSlash(rel)
+	for dir := rel; ; dir = dir[:strings.LastIndexByte(dir, '/')] {
+		c.dirs[dir] = false
+		if !strings.Contains(dir, "/") {
+			break
+		}
+	}
+	return c, rel + "/"
+}
+
+// decide reports whether rel (slash-separated, relative to top) is ignored,
+// assuming its parent directories are not. The ignore file closest to rel
+// that has a matching pattern decides, as in git.
+func (c *ignoreChecker) decide(rel string, isDir bool) bool {
+	dir := rel
+	for dir != "" {
+		if i := strings.LastIndexByte(dir, '/'); i >= 0 {
+			dir = dir[:i]
+		} else {
+			dir = ""
+		}
+		rules, ok := c.rules[dir]
+		if !ok {
+			rules = loadIgnoreRules(filepath.Join(c.top, filepath.FromSlash(dir)), c.names)
+			c.rules[dir] = rules
+		}
+		if rules == nil {
+			continue
+		}
+		sub := rel
+		if dir != "" {
+			sub = rel[len(dir)+1:]
+		}
+		if decided, ignored := rules.match(sub, isDir); decided {
+			return ignored
+		}
+	}
+	return false
+}
+
+// ignored reports whether rel or any directory above it is ignored
+func (c *ignoreChecker) ignored(rel string, isDir bool) bool {
+	if i := strings.LastIndexByte(rel, '/'); i >= 0 {
+		parent := rel[:i]
+		skip, ok := c.dirs[parent]
+		if !ok {
+			skip = c.ignored(parent, true)
+			c.dirs[parent] = skip
+		}
+		if skip {
+			return true
+		}
+	}
+	return rel == ".git" || strings.HasSuffix(rel, "/.git") || c.decide(rel, isDir)
+}
+
+// repoTop returns the closest directory at or above dir that contains a
+// .git entry, or "" if dir is not inside a git work tree
+func repoTop(dir string) string {
+	for {
+		if _, err := os.Lstat(filepath.Join(dir, ".git")); err == nil {
+			return dir
+		}
+		parent := filepath.Dir(dir)
+		if parent == dir {
+			return ""
+		}
+		dir = parent
+	}
+}
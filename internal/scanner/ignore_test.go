@@ -0,0 +1,103 @@
+package scanner
+
+import (
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+)
+
+func TestIgnoreRules(t *testing.T) {
+	for _, tc := range []struct {
+		patterns string // one per line
+		path     string
+		isDir    bool
+		ignored  bool
+	}{
+		{"*.o", "a.o", false, true},
+		{"*.o", "dir/a.o", false, true},
+		{"*.o", "a.cpp", false, false},
+		{"build/", "build", true, true},
+		{"build/", "build", false, false},
+		{"/top.cpp", "top.cpp", false, true},
+		{"/top.cpp", "sub/top.cpp", false, false},
+		{"gen/*.cpp", "gen/a.cpp", false, true},
+		{"gen/*.cpp", "gen/sub/a.cpp", false, false},
+		{"foo/**", "foo/a.cpp", false, true},
+		{"foo/**", "foo/x/y.cpp", false, true},
+		{"foo/**", "foo", true, false},
+		{"a/**/b.cpp", "a/b.cpp", false, true},
+		{"a/**/b.cpp", "a/x/y/b.cpp", false, true},
+		{"**/gen", "x/y/gen", true, true},
+		{"*.cpp\n!keep.cpp", "keep.cpp", false, false},
+		{"*.cpp\n!keep.cpp", "drop.cpp", false, true},
+		{"!keep.cpp\n*.cpp", "keep.cpp", false, true},
+		{"[!a]*.cpp", "b.cpp", false, true},
+		{"[!a]*.cpp", "a.cpp", false, false},
+		{"[^a]*.cpp", "a.cpp", false, false},
+		{"file?.h", "file1.h", false, true},
+		{"# comment\n\n", "# comment", false, false},
+		{`\#hash.cpp`, "#hash.cpp", false, true},
+		{"trailing.cpp   ", "trailing.cpp", false, true},
+	} {
+		var rules ignoreRules
+		for _, line := range strings.Split(tc.patterns, "\n") {
+			if p, ok := compileIgnorePattern(line); ok {
+				rules.patterns = append(rules.patterns, p)
+			}
+		}
+		_, ignored := rules.match(tc.path, tc.isDir)
+		if ignored != tc.ignored {
+			t.Errorf("%q on %s (dir %v): ignored = %v, want %v", tc.patterns, tc.path, tc.isDir, ignored, tc.ignored)
+		}
+	}
+}
+
+// writeTree creates files (slash-separated paths relative to dir, with
+// their contents) under dir
+func writeTree(t *testing.T, dir string, files map[string]string) {
+	t.Helper()
+	for name, content := range files {
+		path := filepath.Join(dir, filepath.FromSlash(name))
+		if err := os.MkdirAll(filepath.Dir(path), 0o755); err != nil {
+			t.Fatal(err)
+		}
+		if err := os.WriteFile(path, []byte(content), 0o644); err != nil {
+			t.Fatal(err)
+		}
+	}
+}
+
+func TestIgnoreChecker(t *testing.T) {
+	top := t.TempDir()
+	writeTree(t, top, map[string]string{
+		".gitignore":            "vendor/\n*.gen.cpp\n",
+		"src/.gitignore":        "!keep.gen.cpp\nlocal/\n",
+		"src/.leakcheckignore":  "skip.cpp\n",
+		"src/local/a.cpp":       "",
+		"src/keep.gen.cpp":      "",
+		"src/other.gen.cpp":     "",
+		"src/skip.cpp":          "",
+		"vendor/lib/a.cpp":      "",
+		"src/vendor_notes.cpp":  "",
+		"docs/local/readme.cpp": "",
+	})
+	c := newIgnoreChecker(top, ignoreFileNames)
+	for _, tc := range []struct {
+		path    string
+		ignored bool
+	}{
+		{"src/local/a.cpp", true},
+		{"src/keep.gen.cpp", false},
+		{"src/other.gen.cpp", true},
+		{"src/skip.cpp", true},
+		{"vendor/lib/a.cpp", true},
+		{"src/vendor_notes.cpp", false},
+		{"docs/local/readme.cpp", false},
+		{".git", true},
+	} {
+		if got := c.ignored(tc.path, false); got != tc.ignored {
+			t.Errorf("ignored(%s) = %v, want %v", tc.path, got, tc.ignored)
+		}
+	}
+}
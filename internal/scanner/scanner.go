@@ -1,81 +1,304 @@
 package scanner
 
 import (
+	"errors"
+	"fmt"
 	"os"
+	"os/exec"
 	"path/filepath"
+	"sort"
 	"strings"
+	"sync"
 )
 
 // Scanner recursively finds C++ files in directories
 type Scanner struct {
 	Excludes []string
+	// IgnoreFiles skips paths matched by .gitignore and .leakcheckignore
+	// files in the scanned directories and above them, up to the root of
+	// the git work tree. Paths given to the scan are never skipped.
+	IgnoreFiles bool
+	// GitFiles lists the files of scanned directories with git ls-files
+	// instead of walking them
+	GitFiles bool
+
+	names map[string]bool // excludes naming a single path component
+	paths []string        // excludes spanning several components
+
+	// Accepts reuses one ignore checker per git work tree, and remembers
+	// the work tree of each directory, until the next ScanStream rereads
+	// the ignore files
+	mu       sync.Mutex
+	tops     map[string]string
+	checkers map[string]*ignoreChecker
 }
 
 // NewScanner creates a new file scanner with exclusion patterns
 func NewScanner(excludes []string) *Scanner {
-	return &Scanner{Excludes: excludes}
+	s := &Scanner{Excludes: excludes, names: make(map[string]bool)}
+	for _, exclude := range excludes {
+		exclude = strings.TrimRight(filepath.FromSlash(exclude), string(filepath.Separator))
+		if exclude == "" {
+			continue
+		}
+		if strings.ContainsRune(exclude, filepath.Separator) {
+			s.paths = append(s.paths, exclude)
+		} else {
+			s.names[exclude] = true
+		}
+	}
+	return s
 }
 
 // ScanPath scans a file or directory for C++ files
 func (s *Scanner) ScanPath(path string) ([]string, error) {
+	var files []string
+	err := s.walkPath(path, func(file string) error {
+		files = append(files, file)
+		return nil
+	})
+	return files, err
+}
+
+// walkPath calls fn for each C++ file found under path
+func (s *Scanner) walkPath(path string, fn func(file string) error) error {
 	info, err := os.Stat(path)
 	if err != nil {
-		return nil, err
+		return err
 	}
 
 	if !info.IsDir() {
 		if s.isCppFile(path) {
-			return []string{path}, nil
+			return fn(path)
 		}
-		return nil, nil
+		return nil
+	}
+	if s.excludedPath(path) {
+		return nil
+	}
+	if s.GitFiles {
+		return s.gitFiles(path, fn)
 	}
 
-	var files []string
-	err = filepath.WalkDir(path, func(filePath string, d os.DirEntry, err error) error {
+	var ignore *ignoreChecker
+	var prefix string
+	if s.IgnoreFiles {
+		ignore, prefix = newWalkChecker(path, ignoreFileNames)
+	}
+	ignored := func(filePath string, isDir bool) bool {
+		if ignore == nil {
+			return false
+		}
+		rel, err := filepath.Rel(path, filePath)
+		return err == nil && ignore.decide(prefix+filepath.ToSlash(rel), isDir)
+	}
+
+	return filepath.WalkDir(path, func(filePath string, d os.DirEntry, err error) error {
 		if err != nil {
 			return nil // Skip files/dirs with errors
 		}
 
-		// Check if this directory should be excluded
+		// Entries are checked by name only: the directories above them
+		// were checked when the walk entered them, and the walk prunes
+		// excluded and ignored directories whole
 		if d.IsDir() {
-			if s.shouldExclude(filePath) {
+			if filePath == path {
+				return nil
+			}
+			if s.excludedName(d.Name(), filePath) || ignore != nil && d.Name() == ".git" || ignored(filePath, true) {
 				return filepath.SkipDir
 			}
 			return nil
 		}
 
 		// Check if this is a C++ file
-		if s.isCppFile(filePath) && !s.shouldExclude(filePath) {
-			files = append(files, filePath)
+		if s.isCppFile(filePath) && !s.excludedName(d.Name(), filePath) && !ignored(filePath, false) {
+			return fn(filePath)
 		}
 
 		return nil
 	})
+}
 
-	return files, err
+// gitFiles calls fn for each C++ file git ls-files lists under root:
+// tracked files, and untracked ones not ignored by git. Files are passed
+// in the order walking the directory would find them.
+func (s *Scanner) gitFiles(root string, fn func(file string) error) error {
+	args := []string{"-C", root, "ls-files", "-z", "--cached", "--others"}
+	if s.IgnoreFiles {
+		args = append(args, "--exclude-standard")
+	}
+	out, err := exec.Command("git", args...).Output()
+	if err != nil {
+		var exitErr *exec.ExitError
+		if errors.As(err, &exitErr) && len(exitErr.Stderr) > 0 {
+			return fmt.Errorf("git ls-files in %s: %s", root, strings.TrimSpace(string(exitErr.Stderr)))
+		}
+		return fmt.Errorf("git ls-files in %s: %w", root, err)
+	}
+
+	var names []string
+	for _, name := range strings.Split(string(out), "\x00") {
+		if name != "" && s.isCppFile(name) {
+			names = append(names, name)
+		}
+	}
+	sort.Slice(names, func(i, j int) bool { return walkOrderLess(names[i], names[j]) })
+
+	// git applies .gitignore itself
+	var ignore *ignoreChecker
+	var prefix string
+	if s.IgnoreFiles {
+		ignore, prefix = newWalkChecker(root, gitIgnoreFileNames)
+	}
+	for i, name := range names {
+		if i > 0 && name == names[i-1] {
+			continue // listed both as tracked and as unmerged
+		}
+		file := filepath.Join(root, filepath.FromSlash(name))
+		if s.excludedBelow(name, file) || ignore != nil && ignore.ignored(prefix+name, false) {
+			continue
+		}
+		// Tracked files may have been deleted from the working tree
+		if info, err := os.Stat(file); err != nil || info.IsDir() {
+			continue
+		}
+		if err := fn(file); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// walkOrderLess orders slash-separated paths the way filepath.WalkDir
+// visits them: component by component, so "a/x" comes before "a-b/x"
+func walkOrderLess(a, b string) bool {
+	n := min(len(a), len(b))
+	for i := 0; i < n; i++ {
+		if a[i] == b[i] {
+			continue
+		}
+		if a[i] == '/' || b[i] == '/' {
+			return a[i] == '/'
+		}
+		return a[i] < b[i]
+	}
+	return len(a) < len(b)
+}
+
+// ScanOrder returns a comparison ordering absolute files the way
+// ScanStream visits them when scanning roots (absolute): by the first
+// root holding a file, then in walk order below it. Files under no root
+// come last.
+func ScanOrder(roots []string) func(a, b string) int {
+	position := func(file string) (int, string) {
+		for i, root := range roots {
+			rel, err := filepath.Rel(root, file)
+			if err != nil || rel == ".." || strings.HasPrefix(rel, ".."+string(filepath.Separator)) {
+				continue
+			}
+			return i, filepath.ToSlash(rel)
+		}
+		return len(roots), filepath.ToSlash(file)
+	}
+	return func(a, b string) int {
+		rootA, relA := position(a)
+		rootB, relB := position(b)
+		switch {
+		case rootA != rootB:
+			return rootA - rootB
+		case walkOrderLess(relA, relB):
+			return -1
+		case walkOrderLess(relB, relA):
+			return 1
+		}
+		return 0
+	}
 }
 
 // ScanPaths scans multiple paths for C++ files
 func (s *Scanner) ScanPaths(paths []string) ([]string, error) {
 	var allFiles []string
+	err := s.ScanStream(paths, func(file string) error {
+		allFiles = append(allFiles, file)
+		return nil
+	})
+	if err != nil {
+		return nil, err
+	}
+	return allFiles, nil
+}
+
+// ScanStream scans multiple paths for C++ files and calls fn with each
+// file as soon as it is discovered. Files are passed as absolute paths,
+// deduplicated, in the same order ScanPaths would return them.
+// Scanning stops at the first error returned by fn.
+func (s *Scanner) ScanStream(paths []string, fn func(file string) error) error {
+	// Ignore files may have changed since the last scan
+	s.mu.Lock()
+	s.tops, s.checkers = nil, nil
+	s.mu.Unlock()
+
 	seen := make(map[string]bool)
+	emit := func(f string) error {
+		absPath, _ := filepath.Abs(f)
+		if seen[absPath] {
+			return nil
+		}
+		seen[absPath] = true
+		return fn(absPath)
+	}
 
 	for _, path := range paths {
-		files, err := s.ScanPath(path)
-		if err != nil {
-			return nil, err
+		if err := s.walkPath(path, emit); err != nil {
+			return err
 		}
+	}
 
-		for _, f := range files {
-			absPath, _ := filepath.Abs(f)
-			if !seen[absPath] {
-				seen[absPath] = true
-				allFiles = append(allFiles, absPath)
-			}
-		}
+	return nil
+}
+
+// Accepts reports whether a file found at path would be scanned:
+// it is a C++ file and neither excluded nor ignored
+func (s *Scanner) Accepts(path string) bool {
+	return s.isCppFile(path) && !s.excludedPath(path) && !(s.IgnoreFiles && s.isIgnored(path))
+}
+
+// isIgnored reports whether the ignore files of the git work tree holding
+// path ignore it or one of its directories
+func (s *Scanner) isIgnored(path string) bool {
+	abs, err := filepath.Abs(path)
+	if err != nil {
+		return false
 	}
+	dir := filepath.Dir(abs)
 
-	return allFiles, nil
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	top, ok := s.tops[dir]
+	if !ok {
+		top = repoTop(dir)
+		if s.tops == nil {
+			s.tops = make(map[string]string)
+		}
+		s.tops[dir] = top
+	}
+	if top == "" {
+		return false
+	}
+	rel, err := filepath.Rel(top, abs)
+	if err != nil {
+		return false
+	}
+	checker := s.checkers[top]
+	if checker == nil {
+		checker = newIgnoreChecker(top, ignoreFileNames)
+		if s.checkers == nil {
+			s.checkers = make(map[string]*ignoreChecker)
+		}
+		s.checkers[top] = checker
+	}
+	return checker.ignored(filepath.ToSlash(rel), false)
 }
 
 func (s *Scanner) isCppFile(path string) bool {
@@ -84,18 +307,48 @@ func (s *Scanner) isCppFile(path string) bool {
 		ext == ".cc" || ext == ".cxx" || ext == ".hxx"
 }
 
-func (s *Scanner) shouldExclude(path string) bool {
-	for _, exclude := range s.Excludes {
-		// Match against directory name or path component
-		base := filepath.Base(path)
-		if base == exclude {
-			return true
+// excludedPath reports whether an exclude names any component of path
+// after the first, or is found in it
+func (s *Scanner) excludedPath(path string) bool {
+	if s.names[filepath.Base(path)] {
+		return true
+	}
+	if len(s.names) > 0 {
+		components := strings.Split(path, string(filepath.Separator))
+		for _, c := range components[1:] {
+			if s.names[c] {
+				return true
+			}
 		}
-		// Also check if exclude pattern is in the path
-		if strings.Contains(path, string(filepath.Separator)+exclude+string(filepath.Separator)) {
-			return true
+	}
+	return s.excludedSpan(path)
+}
+
+// excludedName reports whether an entry named name, found at path while
+// walking a directory that is not excluded, is excluded
+func (s *Scanner) excludedName(name, path string) bool {
+	return s.names[name] || s.excludedSpan(path)
+}
+
+// excludedBelow is excludedName for a file at rel, slash-separated and
+// relative to a directory that is not excluded
+func (s *Scanner) excludedBelow(rel, path string) bool {
+	if len(s.names) > 0 {
+		for _, c := range strings.Split(rel, "/") {
+			if s.names[c] {
+				return true
+			}
 		}
-		if strings.HasSuffix(path, string(filepath.Separator)+exclude) {
+	}
+	return s.excludedSpan(path)
+}
+
+// excludedSpan reports whether an exclude spanning several components
+// matches whole components of path
+func (s *Scanner) excludedSpan(path string) bool {
+	for _, exclude := range s.paths {
+		sep := string(filepath.Separator)
+		if strings.Contains(path, sep+exclude+sep) || strings.HasSuffix(path, sep+exclude) {
 			return true
 		}
 	}
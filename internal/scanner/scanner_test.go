@@ -0,0 +1,68 @@
+package scanner
+
+import (
+	"path/filepath"
+	"slices"
+	"sort"
+	"testing"
+)
+
+func TestScanStream(t *testing.T) {
+	dir := t.TempDir()
+	writeTree(t, dir, map[string]string{
+		".git/HEAD":         "", // Accepts reads ignore files of work trees only
+		".git/x.cpp":        "",
+		".gitignore":        "ignored/\n",
+		"a/x.cpp":           "",
+		"a-b/x.cpp":         "",
+		"a.h":               "",
+		"a/README.md":       "",
+		"ignored/x.cpp":     "",
+		"third_party/x.cpp": "",
+		"b/deep/x.hpp":      "",
+	})
+	s := NewScanner([]string{"third_party"})
+	s.IgnoreFiles = true
+	files, err := s.ScanPaths([]string{dir, filepath.Join(dir, "a", "x.cpp")})
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	var rel []string
+	for _, f := range files {
+		r, _ := filepath.Rel(dir, f)
+		rel = append(rel, filepath.ToSlash(r))
+	}
+	// Walk order, with the file named again deduplicated
+	if want := []string{"a/x.cpp", "a-b/x.cpp", "a.h", "b/deep/x.hpp"}; !slices.Equal(rel, want) {
+		t.Errorf("scanned %q, want %q", rel, want)
+	}
+
+	if !s.Accepts(filepath.Join(dir, "a", "new.cpp")) || s.Accepts(filepath.Join(dir, "ignored", "new.cpp")) ||
+		s.Accepts(filepath.Join(dir, "third_party", "new.cpp")) || s.Accepts(filepath.Join(dir, "a", "notes.txt")) {
+		t.Error("Accepts disagrees with the scan")
+	}
+}
+
+func TestScanOrder(t *testing.T) {
+	dir := t.TempDir()
+	writeTree(t, dir, map[string]string{
+		"z/b.cpp":   "",
+		"z/a/x.cpp": "",
+		"z/a-b.cpp": "",
+		"a/y.cpp":   "",
+		"a/x.cpp":   "",
+	})
+	roots := []string{filepath.Join(dir, "z"), filepath.Join(dir, "a")}
+	want, err := NewScanner(nil).ScanPaths(roots)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	got := slices.Clone(want)
+	sort.Strings(got)
+	slices.SortFunc(got, ScanOrder(roots))
+	if !slices.Equal(got, want) {
+		t.Errorf("ScanOrder sorted %q, want the scan order %q", got, want)
+	}
+}
@@ -0,0 +1,227 @@
+package shard
+
+import (
+	"bytes"
+	"encoding/binary"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"hash/fnv"
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
+
+	"leakcheck/internal/parser"
+)
+
+// A dump is the magic "LKSH", a uvarint format version, the uvarint length
+// of a JSON header (the Dump, with a class count per entry), and a class
+// file (see parser.EncodeClasses) holding every entry's classes in order
+const (
+	dumpMagic = "LKSH"
+	// formatVersion is bumped whenever the dump layout changes
+	formatVersion = 3
+)
+
+// Spec selects shard Index (1-based) of Count. Each shard parses the files
+// whose path hashes to it and writes a Dump; merging the dumps in scan order
+// yields the same classes as a single run over every file.
+type Spec struct {
+	Index int
+	Count int
+}
+
+// ParseSpec parses "i/N", as given to --shard
+func ParseSpec(s string) (Spec, error) {
+	i, n, ok := strings.Cut(s, "/")
+	index, err1 := strconv.Atoi(i)
+	count, err2 := strconv.Atoi(n)
+	if !ok || err1 != nil || err2 != nil || count < 1 || index < 1 || index > count {
+		return Spec{}, fmt.Errorf("invalid shard %q (want i/N with 1 <= i <= N)", s)
+	}
+	return Spec{Index: index, Count: count}, nil
+}
+
+func (s Spec) String() string {
+	return fmt.Sprintf("%d/%d", s.Index, s.Count)
+}
+
+// Owns reports whether the file with the given Key belongs to this shard
+func (s Spec) Owns(key string) bool {
+	h := fnv.New64a()
+	h.Write([]byte(key))
+	return h.Sum64()%uint64(s.Count) == uint64(s.Index-1)
+}
+
+// Key returns the name a shard partition hashes for file, found by
+// scanning roots (both absolute): the position of the first root holding
+// it and its slash-separated path below that root. It does not depend on
+// where the tree is checked out, so nodes with different checkout
+// directories split it alike.
+func Key(file string, roots []string) string {
+	for i, root := range roots {
+		rel, err := filepath.Rel(root, file)
+		if err != nil || rel == ".." || strings.HasPrefix(rel, ".."+string(filepath.Separator)) {
+			continue
+		}
+		if rel == "." {
+			rel = filepath.Base(file) // the root is the file itself
+		}
+		return strconv.Itoa(i) + ":" + filepath.ToSlash(rel)
+	}
+	return filepath.ToSlash(file)
+}
+
+// Dump is the partial result of one shard
+type Dump struct {
+	Version int      `json:"version"`
+	Tool    string   `json:"tool"` // leakcheck version that wrote the dump
+	Shard   int      `json:"shard"`
+	Shards  int      `json:"shards"`
+	Paths   []string `json:"paths"` // the scanned paths, as given
+	Files   int      `json:"files"` // files scanned, across all shards
+	Entries []Entry  `json:"entries"`
+}
+
+// Entry is one file parsed by a shard
+type Entry struct {
+	Index   int            `json:"index"` // position in the full scan order
+	File    string         `json:"file"`
+	Classes []parser.Class `json:"-"`
+	Count   int            `json:"classes"` // len(Classes), for decoding
+	Error   string         `json:"error,omitempty"`
+	Skipped string         `json:"skipped,omitempty"` // why a file over a limit was not parsed
+}
+
+// NewDump returns an empty dump for spec
+func NewDump(spec Spec, tool string, paths []string) *Dump {
+	return &Dump{
+		Version: formatVersion,
+		Tool:    tool,
+		Shard:   spec.Index,
+		Shards:  spec.Count,
+		Paths:   paths,
+	}
+}
+
+// Write writes the dump to path
+func (d *Dump) Write(path string) error {
+	var classes []parser.Class
+	for i := range d.Entries {
+		d.Entries[i].Count = len(d.Entries[i].Classes)
+		classes = append(classes, d.Entries[i].Classes...)
+	}
+	header, err := json.Marshal(d)
+	if err != nil {
+		return err
+	}
+
+	data := append([]byte(dumpMagic), binary.AppendUvarint(nil, formatVersion)...)
+	data = binary.AppendUvarint(data, uint64(len(header)))
+	data = append(data, header...)
+	data = append(data, parser.EncodeClasses(classes)...)
+	return os.WriteFile(path, data, 0o644)
+}
+
+// Read reads a dump written by Write
+func Read(path string) (*Dump, error) {
+	data, release, err := parser.ReadSource(path)
+	if err != nil {
+		return nil, err
+	}
+	defer release()
+
+	d, err := decode(data)
+	if err != nil {
+		return nil, fmt.Errorf("%s: %w", path, err)
+	}
+	return d, nil
+}
+
+func decode(data []byte) (*Dump, error) {
+	if !bytes.HasPrefix(data, []byte(dumpMagic)) {
+		return nil, errors.New("not a shard dump")
+	}
+	data = data[len(dumpMagic):]
+	version, n := binary.Uvarint(data)
+	if n <= 0 || version != formatVersion {
+		return nil, fmt.Errorf("unsupported dump version %d", version)
+	}
+	data = data[n:]
+	length, n := binary.Uvarint(data)
+	if n <= 0 || length > uint64(len(data)-n) {
+		return nil, errors.New("corrupt shard dump")
+	}
+	data = data[n:]
+
+	var d Dump
+	if err := json.Unmarshal(data[:length], &d); err != nil {
+		return nil, err
+	}
+	classes, err := parser.DecodeClasses(data[length:])
+	if err != nil {
+		return nil, err
+	}
+	for i := range d.Entries {
+		entry := &d.Entries[i]
+		if entry.Count < 0 || entry.Count > len(classes) {
+			return nil, errors.New("corrupt shard dump")
+		}
+		entry.Classes, classes = classes[:entry.Count:entry.Count], classes[entry.Count:]
+	}
+	if len(classes) != 0 {
+		return nil, errors.New("corrupt shard dump")
+	}
+	return &d, nil
+}
+
+// Merge checks that dumps are every shard of one scan, and returns their
+// entries in scan order
+func Merge(dumps []*Dump) ([]Entry, error) {
+	if len(dumps) == 0 {
+		return nil, fmt.Errorf("no shard dumps")
+	}
+	first := dumps[0]
+	seen := make(map[int]bool, len(dumps))
+	total := 0
+	for _, d := range dumps {
+		switch {
+		case d.Shards != first.Shards:
+			return nil, fmt.Errorf("shard %d/%d does not belong with shard %d/%d", d.Shard, d.Shards, first.Shard, first.Shards)
+		case d.Tool != first.Tool:
+			return nil, fmt.Errorf("shard %d/%d was written by leakcheck %s, shard %d/%d by %s", d.Shard, d.Shards, d.Tool, first.Shard, first.Shards, first.Tool)
+		case d.Files != first.Files || strings.Join(d.Paths, "\x00") != strings.Join(first.Paths, "\x00"):
+			return nil, fmt.Errorf("shard %d/%d scanned different files than shard %d/%d", d.Shard, d.Shards, first.Shard, first.Shards)
+		case seen[d.Shard]:
+			return nil, fmt.Errorf("shard %d/%d given twice", d.Shard, d.Shards)
+		}
+		seen[d.Shard] = true
+		total += len(d.Entries)
+	}
+	for i := 1; i <= first.Shards; i++ {
+		if !seen[i] {
+			return nil, fmt.Errorf("shard %d/%d is missing", i, first.Shards)
+		}
+	}
+	if total != first.Files {
+		return nil, fmt.Errorf("shards hold %d file(s), but the scan found %d", total, first.Files)
+	}
+
+	entries := make([]Entry, 0, total)
+	for _, d := range dumps {
+		entries = append(entries, d.Entries...)
+	}
+	sort.Slice(entries, func(i, j int) bool { return entries[i].Index < entries[j].Index })
+	// Every position of the scan must be held by exactly one shard
+	for i, entry := range entries {
+		if entry.Index != i {
+			if i > 0 && entry.Index == entries[i-1].Index {
+				return nil, fmt.Errorf("scan position %d (%s) is in more than one shard", entry.Index, entry.File)
+			}
+			return nil, fmt.Errorf("no shard holds scan position %d", i)
+		}
+	}
+	return entries, nil
+}
@@ -0,0 +1,155 @@
+package shard
+
+import (
+	"fmt"
+	"path/filepath"
+	"strings"
+	"testing"
+
+	"leakcheck/internal/parser"
+)
+
+func TestParseSpec(t *testing.T) {
+	for _, s := range []string{"1/1", "2/3", "3/3"} {
+		spec, err := ParseSpec(s)
+		if err != nil || spec.String() != s {
+			t.Errorf("ParseSpec(%q) = %v, %v", s, spec, err)
+		}
+	}
+	for _, s := range []string{"", "1", "0/2", "3/2", "1/0", "a/b", "1/2/3"} {
+		if _, err := ParseSpec(s); err == nil {
+			t.Errorf("ParseSpec(%q) succeeded", s)
+		}
+	}
+}
+
+func TestOwnsPartitions(t *testing.T) {
+	const count = 5
+	owned := make([]int, count)
+	for i := 0; i < 1000; i++ {
+		key := fmt.Sprintf("0:dir%d/file%d.cpp", i%7, i)
+		owners := 0
+		for index := 1; index <= count; index++ {
+			if (Spec{Index: index, Count: count}).Owns(key) {
+				owners++
+				owned[index-1]++
+			}
+		}
+		if owners != 1 {
+			t.Fatalf("%s is owned by %d shards", key, owners)
+		}
+	}
+	for i, n := range owned {
+		if n == 0 {
+			t.Errorf("shard %d/%d owns no file", i+1, count)
+		}
+	}
+}
+
+func TestKey(t *testing.T) {
+	roots := []string{"/work/src", "/work/lib", "/work/one.cpp"}
+	for _, tc := range []struct{ file, want string }{
+		{"/work/src/a/b.cpp", "0:a/b.cpp"},
+		{"/work/lib/b.cpp", "1:b.cpp"},
+		{"/work/one.cpp", "2:one.cpp"},
+		{"/elsewhere/c.cpp", "/elsewhere/c.cpp"},
+		{"/work/src-old/c.cpp", "/work/src-old/c.cpp"},
+	} {
+		if got := Key(filepath.FromSlash(tc.file), roots); got != tc.want {
+			t.Errorf("Key(%s) = %q, want %q", tc.file, got, tc.want)
+		}
+	}
+	// Checkout location does not matter
+	if Key("/home/a/src/x.cpp", []string{"/home/a/src"}) != Key("/ci/b/src/x.cpp", []string{"/ci/b/src"}) {
+		t.Error("the same file in two checkouts has different keys")
+	}
+}
+
+// dumps splits entries for files across count shards the way --shard does
+func dumps(t *testing.T, files []string, count int) []*Dump {
+	t.Helper()
+	var out []*Dump
+	for index := 1; index <= count; index++ {
+		spec := Spec{Index: index, Count: count}
+		d := NewDump(spec, "test", []string{"/src"})
+		d.Files = len(files)
+		for i, file := range files {
+			if !spec.Owns(Key(file, []string{"/src"})) {
+				continue
+			}
+			classes := parser.ParseSource(file, []byte(fmt.Sprintf("class C%d { int *p;\npublic:\n  C%d() { p = new int; }\n};\n", i, i)))
+			d.Entries = append(d.Entries, Entry{Index: i, File: file, Classes: classes})
+		}
+		out = append(out, d)
+	}
+	return out
+}
+
+func TestDumpRoundTrip(t *testing.T) {
+	files := []string{"/src/a.cpp", "/src/b.cpp", "/src/c.cpp"}
+	d := dumps(t, files, 1)[0]
+	d.Entries = append(d.Entries, Entry{Index: 3, File: "/src/d.cpp", Error: "permission denied"},
+		Entry{Index: 4, File: "/src/e.cpp", Skipped: "file too large"})
+	path := filepath.Join(t.TempDir(), "shard.lks")
+	if err := d.Write(path); err != nil {
+		t.Fatal(err)
+	}
+
+	read, err := Read(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if read.Tool != "test" || read.Shard != 1 || read.Shards != 1 || len(read.Entries) != 5 {
+		t.Fatalf("read %+v", read)
+	}
+	for i, entry := range read.Entries[:3] {
+		if entry.File != files[i] || len(entry.Classes) != 1 || entry.Classes[0].Name != fmt.Sprintf("C%d", i) {
+			t.Errorf("entry %d = %+v", i, entry)
+		}
+	}
+	if last := read.Entries[3]; last.Error != "permission denied" || len(last.Classes) != 0 {
+		t.Errorf("error entry = %+v", last)
+	}
+	if last := read.Entries[4]; last.Skipped != "file too large" || last.Error != "" {
+		t.Errorf("skipped entry = %+v", last)
+	}
+}
+
+func TestMerge(t *testing.T) {
+	var files []string
+	for i := 0; i < 20; i++ {
+		files = append(files, fmt.Sprintf("/src/f%02d.cpp", i))
+	}
+	entries, err := Merge(dumps(t, files, 3))
+	if err != nil {
+		t.Fatal(err)
+	}
+	for i, entry := range entries {
+		if entry.Index != i || entry.File != files[i] {
+			t.Fatalf("entry %d is %d %s, want scan order", i, entry.Index, entry.File)
+		}
+	}
+
+	for _, tc := range []struct {
+		name   string
+		modify func(ds []*Dump) []*Dump
+		want   string
+	}{
+		{"missing shard", func(ds []*Dump) []*Dump { return ds[:2] }, "is missing"},
+		{"shard twice", func(ds []*Dump) []*Dump { return append(ds, ds[0]) }, "given twice"},
+		{"other tool", func(ds []*Dump) []*Dump { ds[1].Tool = "other"; return ds }, "written by"},
+		{"other paths", func(ds []*Dump) []*Dump { ds[2].Paths = []string{"/other"}; return ds }, "different files"},
+		{"lost entry", func(ds []*Dump) []*Dump { ds[0].Entries = ds[0].Entries[1:]; return ds }, "shards hold"},
+		{"position twice", func(ds []*Dump) []*Dump {
+			ds[0].Entries[0].Index = ds[1].Entries[0].Index
+			return ds
+		}, ""},
+	} {
+		t.Run(tc.name, func(t *testing.T) {
+			_, err := Merge(tc.modify(dumps(t, files, 3)))
+			if err == nil || !strings.Contains(err.Error(), tc.want) {
+				t.Errorf("Merge error = %v, want one containing %q", err, tc.want)
+			}
+		})
+	}
+}
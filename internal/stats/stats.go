@@ -0,0 +1,340 @@
+package stats
+
+import (
+	"encoding/json"
+	"fmt"
+	"io"
+	"runtime"
+	"sort"
+	"time"
+)
+
+// Phase names used by the CLI
+const (
+	PhaseParse   = "scan+parse"
+	PhaseMerge   = "merge"
+	PhaseAnalyze = "analyze"
+	PhaseReport  = "report"
+	// PhaseAnalyzeReport is used when findings are streamed while analyzing
+	PhaseAnalyzeReport = "analyze+report"
+)
+
+// Collector records per-phase timings, work counts and allocations for one run.
+// All methods are no-ops on a nil *Collector, so callers need not check
+// whether stats are enabled. It is not safe for concurrent use.
+type Collector struct {
+	start    time.Time
+	startMem runtime.MemStats
+
+	phases   []Phase
+	phase    string // current phase, "" if none
+	phaseAt  time.Time
+	phaseMem runtime.MemStats
+
+	top     int
+	slowest []File // sorted by descending parse time, at most top entries
+
+	files     int
+	bytes     int64
+	tokens    int64
+	cacheHits int
+	skipped   int
+	skipBytes int64
+	limited   []LimitedFile
+	rules     []Rule
+	parseTime time.Duration
+	classes   int
+	leaks     int
+}
+
+// Phase is the cost of one stage of the pipeline
+type Phase struct {
+	Name       string        `json:"name"`
+	Duration   time.Duration `json:"-"`
+	Seconds    float64       `json:"seconds"`
+	Mallocs    uint64        `json:"mallocs"`
+	AllocBytes uint64        `json:"alloc_bytes"`
+}
+
+// File is the parse cost of one file
+type File struct {
+	Path     string        `json:"path"`
+	Bytes    int64         `json:"bytes"`
+	Tokens   int           `json:"tokens"`
+	Duration time.Duration `json:"-"`
+	Seconds  float64       `json:"seconds"`
+	Cached   bool          `json:"cached"`
+}
+
+// LimitedFile is a file skipped for going over a parse limit
+type LimitedFile struct {
+	Path   string `json:"path"`
+	Reason string `json:"reason"`
+}
+
+// Rule is the cost of one analyzer rule
+type Rule struct {
+	ID       string        `json:"id"`
+	Duration time.Duration `json:"-"`
+	Seconds  float64       `json:"seconds"` // summed over all analysis workers
+	Findings int           `json:"findings"`
+}
+
+// Report is the summary of a run, as written by WriteText and WriteJSON
+type Report struct {
+	WallSeconds       float64       `json:"wall_seconds"`
+	Phases            []Phase       `json:"phases"`
+	Files             int           `json:"files"`
+	Bytes             int64         `json:"bytes"`
+	Tokens            int64         `json:"tokens"`
+	CacheHits         int           `json:"cache_hits"`
+	SkippedFiles      int           `json:"skipped_files"` // not lexed, see --prefilter
+	SkippedBytes      int64         `json:"skipped_bytes"`
+	LimitedFiles      []LimitedFile `json:"limited_files"` // over a --max-file-* or --parse-timeout limit
+	Rules             []Rule        `json:"rules"`
+	ParseSeconds      float64       `json:"parse_seconds"` // summed over all parse workers
+	TokensPerSecond   float64       `json:"tokens_per_second"`
+	MBPerSecond       float64       `json:"mb_per_second"`
+	Classes           int           `json:"classes"`
+	Leaks             int           `json:"leaks"`
+	Mallocs           uint64        `json:"mallocs"`
+	TotalAllocBytes   uint64        `json:"total_alloc_bytes"`
+	HeapInuseBytes    uint64        `json:"heap_inuse_bytes"`
+	SysBytes          uint64        `json:"sys_bytes"`
+	NumGC             uint32        `json:"num_gc"`
+	GCPauseSeconds    float64       `json:"gc_pause_seconds"`
+	SlowestFiles      []File        `json:"slowest_files"`
+	SlowestFilesLimit int           `json:"slowest_files_limit"`
+}
+
+// New starts collecting. top is the number of slowest files to keep.
+func New(top int) *Collector {
+	c := &Collector{start: time.Now(), top: top}
+	runtime.ReadMemStats(&c.startMem)
+	return c
+}
+
+// StartPhase ends the current phase, if any, and starts a new one
+func (c *Collector) StartPhase(name string) {
+	if c == nil {
+		return
+	}
+	c.EndPhase()
+	c.phase = name
+	c.phaseAt = time.Now()
+	runtime.ReadMemStats(&c.phaseMem)
+}
+
+// EndPhase ends the current phase
+func (c *Collector) EndPhase() {
+	if c == nil || c.phase == "" {
+		return
+	}
+	elapsed := time.Since(c.phaseAt)
+	var mem runtime.MemStats
+	runtime.ReadMemStats(&mem)
+	c.phases = append(c.phases, Phase{
+		Name:       c.phase,
+		Duration:   elapsed,
+		Seconds:    elapsed.Seconds(),
+		Mallocs:    mem.Mallocs - c.phaseMem.Mallocs,
+		AllocBytes: mem.TotalAlloc - c.phaseMem.TotalAlloc,
+	})
+	c.phase = ""
+}
+
+// AddFile records one parsed (or cache-loaded) file
+func (c *Collector) AddFile(f File) {
+	if c == nil {
+		return
+	}
+	c.files++
+	c.bytes += f.Bytes
+	c.tokens += int64(f.Tokens)
+	c.parseTime += f.Duration
+	if f.Cached {
+		c.cacheHits++
+	}
+
+	if c.top <= 0 || (len(c.slowest) == c.top && f.Duration <= c.slowest[len(c.slowest)-1].Duration) {
+		return
+	}
+	f.Seconds = f.Duration.Seconds()
+	i := sort.Search(len(c.slowest), func(i int) bool { return c.slowest[i].Duration < f.Duration })
+	if len(c.slowest) < c.top {
+		c.slowest = append(c.slowest, File{})
+	}
+	copy(c.slowest[i+1:], c.slowest[i:])
+	c.slowest[i] = f
+}
+
+// SkipFile records a file the prefilter found no need to lex
+func (c *Collector) SkipFile(bytes int64) {
+	if c == nil {
+		return
+	}
+	c.skipped++
+	c.skipBytes += bytes
+}
+
+// LimitFile records a file skipped for going over a parse limit
+func (c *Collector) LimitFile(path, reason string) {
+	if c == nil {
+		return
+	}
+	c.limited = append(c.limited, LimitedFile{Path: path, Reason: reason})
+}
+
+// AddRule records the time an analyzer rule took and its findings
+func (c *Collector) AddRule(id string, d time.Duration, findings int) {
+	if c == nil {
+		return
+	}
+	c.rules = append(c.rules, Rule{ID: id, Duration: d, Seconds: d.Seconds(), Findings: findings})
+}
+
+// SetResults records the number of merged classes and reported leaks
+func (c *Collector) SetResults(classes, leaks int) {
+	if c == nil {
+		return
+	}
+	c.classes = classes
+	c.leaks = leaks
+}
+
+// Finish ends the current phase and returns the summary of the run
+func (c *Collector) Finish() Report {
+	if c == nil {
+		return Report{}
+	}
+	c.EndPhase()
+	wall := time.Since(c.start)
+	var mem runtime.MemStats
+	runtime.ReadMemStats(&mem)
+
+	r := Report{
+		WallSeconds:       wall.Seconds(),
+		Phases:            c.phases,
+		Files:             c.files,
+		Bytes:             c.bytes,
+		Tokens:            c.tokens,
+		CacheHits:         c.cacheHits,
+		SkippedFiles:      c.skipped,
+		SkippedBytes:      c.skipBytes,
+		LimitedFiles:      c.limited,
+		Rules:             c.rules,
+		ParseSeconds:      c.parseTime.Seconds(),
+		Classes:           c.classes,
+		Leaks:             c.leaks,
+		Mallocs:           mem.Mallocs - c.startMem.Mallocs,
+		TotalAllocBytes:   mem.TotalAlloc - c.startMem.TotalAlloc,
+		HeapInuseBytes:    mem.HeapInuse,
+		SysBytes:          mem.Sys,
+		NumGC:             mem.NumGC - c.startMem.NumGC,
+		GCPauseSeconds:    time.Duration(mem.PauseTotalNs - c.startMem.PauseTotalNs).Seconds(),
+		SlowestFiles:      c.slowest,
+		SlowestFilesLimit: c.top,
+	}
+	// Throughput is measured against the parse phase's wall time
+	for _, p := range c.phases {
+		if p.Name == PhaseParse && p.Duration > 0 {
+			r.TokensPerSecond = float64(c.tokens) / p.Seconds
+			r.MBPerSecond = float64(c.bytes) / (1 << 20) / p.Seconds
+		}
+	}
+	if r.Phases == nil {
+		r.Phases = []Phase{}
+	}
+	if r.SlowestFiles == nil {
+		r.SlowestFiles = []File{}
+	}
+	if r.LimitedFiles == nil {
+		r.LimitedFiles = []LimitedFile{}
+	}
+	if r.Rules == nil {
+		r.Rules = []Rule{}
+	}
+	return r
+}
+
+// WriteJSON writes the report as a JSON document
+func (r Report) WriteJSON(w io.Writer) error {
+	encoder := json.NewEncoder(w)
+	encoder.SetIndent("", "  ")
+	return encoder.Encode(r)
+}
+
+// WriteText writes the report in a human-readable form
+func (r Report) WriteText(w io.Writer) error {
+	var err error
+	printf := func(format string, args ...interface{}) {
+		if err == nil {
+			_, err = fmt.Fprintf(w, format, args...)
+		}
+	}
+
+	printf("\nStats:\n")
+	printf("  %-16s %9s %12s %12s\n", "phase", "time", "mallocs", "allocated")
+	for _, p := range r.Phases {
+		printf("  %-16s %9s %12d %12s\n", p.Name, formatSeconds(p.Seconds), p.Mallocs, formatBytes(p.AllocBytes))
+	}
+	printf("  %-16s %9s %12d %12s\n", "total", formatSeconds(r.WallSeconds), r.Mallocs, formatBytes(r.TotalAllocBytes))
+
+	if len(r.Rules) > 0 {
+		printf("\n  %-16s %9s %12s\n", "rule", "time", "findings")
+		for _, rule := range r.Rules {
+			printf("  %-16s %9s %12d\n", rule.ID, formatSeconds(rule.Seconds), rule.Findings)
+		}
+	}
+
+	printf("\n  files:   %d (%d from cache), %s, %d tokens\n", r.Files, r.CacheHits, formatBytes(uint64(r.Bytes)), r.Tokens)
+	if r.SkippedFiles > 0 {
+		printf("  skipped: %d file(s), %s, without new or delete\n", r.SkippedFiles, formatBytes(uint64(r.SkippedBytes)))
+	}
+	if len(r.LimitedFiles) > 0 {
+		printf("  limits:  %d file(s) skipped over a parse limit\n", len(r.LimitedFiles))
+	}
+	printf("  speed:   %.0f tokens/s, %.1f MB/s (parse time summed over workers: %s)\n",
+		r.TokensPerSecond, r.MBPerSecond, formatSeconds(r.ParseSeconds))
+	printf("  results: %d class(es), %d finding(s)\n", r.Classes, r.Leaks)
+	printf("  memory:  heap in use %s, from OS %s, %d GC(s), %s paused\n",
+		formatBytes(r.HeapInuseBytes), formatBytes(r.SysBytes), r.NumGC, formatSeconds(r.GCPauseSeconds))
+
+	if len(r.SlowestFiles) > 0 {
+		printf("\n  slowest files to parse:\n")
+		for _, f := range r.SlowestFiles {
+			cached := ""
+			if f.Cached {
+				cached = " (cached)"
+			}
+			printf("  %9s %10s %8d tokens  %s%s\n", formatSeconds(f.Seconds), formatBytes(uint64(f.Bytes)), f.Tokens, f.Path, cached)
+		}
+	}
+
+	if len(r.LimitedFiles) > 0 {
+		printf("\n  skipped over a parse limit:\n")
+		for _, f := range r.LimitedFiles {
+			printf("  %s: %s\n", f.Path, f.Reason)
+		}
+	}
+	return err
+}
+
+func formatSeconds(s float64) string {
+	if s < 1 {
+		return fmt.Sprintf("%.1fms", s*1000)
+	}
+	return fmt.Sprintf("%.2fs", s)
+}
+
+func formatBytes(n uint64) string {
+	switch {
+	case n >= 1<<30:
+		return fmt.Sprintf("%.1f GB", float64(n)/(1<<30))
+	case n >= 1<<20:
+		return fmt.Sprintf("%.1f MB", float64(n)/(1<<20))
+	case n >= 1<<10:
+		return fmt.Sprintf("%.1f KB", float64(n)/(1<<10))
+	}
+	return fmt.Sprintf("%d B", n)
+}
@@ -0,0 +1,62 @@
+package stats
+
+import (
+	"bytes"
+	"encoding/json"
+	"testing"
+	"time"
+)
+
+func TestNilCollector(t *testing.T) {
+	var c *Collector
+	c.StartPhase(PhaseParse)
+	c.AddFile(File{Path: "a.cpp", Bytes: 10})
+	c.SkipFile(10)
+	c.LimitFile("b.cpp", "too big")
+	c.AddRule("missing-delete", time.Second, 1)
+	c.SetResults(1, 1)
+	c.EndPhase()
+	if r := c.Finish(); r.Files != 0 || r.Phases != nil {
+		t.Errorf("nil collector reported %+v", r)
+	}
+}
+
+func TestCollector(t *testing.T) {
+	c := New(2)
+	c.StartPhase(PhaseParse)
+	for i, d := range []time.Duration{3, 1, 5, 2} {
+		c.AddFile(File{Path: string(rune('a'+i)) + ".cpp", Bytes: 100, Tokens: 10, Duration: d * time.Millisecond, Cached: i == 0})
+	}
+	c.SkipFile(50)
+	c.LimitFile("big.cpp", "exceeds the 10-byte limit")
+	c.AddRule("missing-delete", time.Millisecond, 3)
+	c.SetResults(7, 3)
+	r := c.Finish()
+
+	if r.Files != 4 || r.Bytes != 400 || r.Tokens != 40 || r.CacheHits != 1 || r.SkippedFiles != 1 || r.SkippedBytes != 50 {
+		t.Errorf("counts = %+v", r)
+	}
+	if len(r.Phases) != 1 || r.Phases[0].Name != PhaseParse {
+		t.Errorf("phases = %+v", r.Phases)
+	}
+	// The two slowest files, slowest first
+	if len(r.SlowestFiles) != 2 || r.SlowestFiles[0].Path != "c.cpp" || r.SlowestFiles[1].Path != "a.cpp" {
+		t.Errorf("slowest files = %+v", r.SlowestFiles)
+	}
+	if len(r.LimitedFiles) != 1 || r.Classes != 7 || r.Leaks != 3 || len(r.Rules) != 1 {
+		t.Errorf("results = %+v", r)
+	}
+
+	var out bytes.Buffer
+	if err := r.WriteJSON(&out); err != nil {
+		t.Fatal(err)
+	}
+	var decoded Report
+	if err := json.Unmarshal(out.Bytes(), &decoded); err != nil || decoded.Files != 4 {
+		t.Errorf("JSON report %s: %v", out.String(), err)
+	}
+	out.Reset()
+	if err := r.WriteText(&out); err != nil || out.Len() == 0 {
+		t.Errorf("text report: %v", err)
+	}
+}
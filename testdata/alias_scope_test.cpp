@@ -0,0 +1,39 @@
+// alias_scope_test.cpp - Aliases in one method do not carry over to another
+
+class LocalAliasLeak {
+private:
+  int *first;
+  int *second;
+
+public:
+  LocalAliasLeak() {
+    first = new int(1);
+    second = new int(2); // LEAK: never deleted; tmp below is a different local each time
+  }
+
+  int peekFirst() {
+    int *tmp = first;
+    return *tmp;
+  }
+
+  int peekSecond() {
+    int *tmp = second;
+    return *tmp;
+  }
+
+  ~LocalAliasLeak() { delete first; }
+};
+
+class MemberAliasSafe {
+private:
+  int *current;
+  int *backup;
+
+public:
+  MemberAliasSafe() {
+    current = new int(1);
+    backup = current; // Members alias across methods
+  }
+
+  ~MemberAliasSafe() { delete backup; }
+};